@@ -28,6 +28,7 @@
 #include "LLVMValueExpr.h"
 #include "Ops.h"
 #include "PlaceholderInstruction.h"
+#include "StackAlloc.h"
 #include "Utils.h"
 #include "VarDefs.h"
 #include "VTableBuilder.h"
@@ -45,6 +46,7 @@
 #include <llvm/Bitcode/ReaderWriter.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Metadata.h>
 #include <llvm/PassManager.h>
 #include <llvm/IR/CallingConv.h>
 #include <llvm/Support/FormattedStream.h>
@@ -55,6 +57,7 @@
 
 #include <spug/Exception.h>
 #include <spug/StringFmt.h>
+#include <spug/stlutil.h>
 
 #include <model/AllocExpr.h>
 #include <model/AssignExpr.h>
@@ -934,6 +937,26 @@ ResultExprPtr LLVMBuilder::emitNull(Context &context,
     return new BResultExpr(nullExpr, lastValue);
 }
 
+namespace {
+    // Returns true if 'type' is derived from Object.  We can't rely on
+    // construct->objectType here because it isn't set until crack.lang has
+    // finished loading.
+    bool isObjectType(Context &context, TypeDef *type) {
+        if (context.construct->objectType)
+            return type->isDerivedFrom(context.construct->objectType.get());
+
+        if (type->getFullName() == "crack.lang.Object")
+            return true;
+        for (TypeDef::TypeVec::const_iterator parent = type->parents.begin();
+             parent != type->parents.end();
+             ++parent
+             )
+            if (isObjectType(context, parent->get()))
+                return true;
+        return false;
+    }
+}
+
 ResultExprPtr LLVMBuilder::emitAlloc(Context &context, AllocExpr *allocExpr,
                                      Expr *countExpr
                                      ) {
@@ -960,13 +983,42 @@ ResultExprPtr LLVMBuilder::emitAlloc(Context &context, AllocExpr *allocExpr,
         countVal = ConstantInt::get(uintzType->rep, 1);
     }
 
-    // construct a call to the "calloc" function
-    BTypeDef *voidptrType =
-        BTypeDefPtr::arcast(context.construct->voidptrType);
-    vector<Value *> callocArgs(2);
-    callocArgs[0] = countVal;
-    callocArgs[1] = size;
-    Value *result = builder.CreateCall(callocFunc, callocArgs);
+    // Instances of Object are freed by Object.oper release(), which uses the
+    // runtime's allocator, so we have to allocate them with it.  Everything
+    // else gets allocated by "calloc" and is freed by the user with free().
+    // When profiling allocations, pass the class name to the profiling
+    // version of the allocator.
+    CallInst *result;
+    bool profiled = false;
+    if (!countExpr && isObjectType(context, btype)) {
+        if (spug::contains(options->optionMap, "allocProfile")) {
+            result = builder.CreateCall2(
+                module->getFunction("__CrackProfAlloc"),
+                size,
+                builder.CreateGlobalStringPtr(btype->getFullName())
+            );
+            profiled = true;
+        } else {
+            result = builder.CreateCall(module->getFunction("__CrackAlloc"),
+                                        size
+                                        );
+        }
+    } else {
+        // construct a call to the "calloc" function
+        vector<Value *> callocArgs(2);
+        callocArgs[0] = countVal;
+        callocArgs[1] = size;
+        result = builder.CreateCall(callocFunc, callocArgs);
+    }
+
+    // mark allocations of a single object so the stack allocation pass can
+    // find them (unless we're profiling them).
+    if (!countExpr && !profiled)
+        result->setMetadata(CRACK_ALLOC_MD,
+                            MDNode::get(getGlobalContext(),
+                                        ArrayRef<Value *>()
+                                        )
+                            );
     lastValue = builder.CreateBitCast(result, tp);
 
     return new BResultExpr(allocExpr, lastValue);
@@ -1305,6 +1357,8 @@ namespace {
         slave->addAlias(master->lookUp("__CrackBadCast").get());
         slave->addAlias(master->lookUp("__CrackCleanupException").get());
         slave->addAlias(master->lookUp("__CrackExceptionFrame").get());
+        slave->addAlias(master->lookUp("__CrackAlloc").get());
+        slave->addAlias(master->lookUp("__CrackProfAlloc").get());
     }
 }
 
@@ -3490,6 +3544,28 @@ void LLVMBuilder::createModuleCommon(Context &context) {
         callocFunc = f.funcDef->getFuncRep(*this);
     }
 
+    // create "voidptr __CrackAlloc(uintz size)"
+    {
+        FuncBuilder f(context, FuncDef::builtin, voidptrType, "__CrackAlloc",
+                      1
+                      );
+        f.addArg("size", uintzType);
+        f.setSymbolName("__CrackAlloc");
+        f.finish();
+    }
+
+    // create "voidptr __CrackProfAlloc(uintz size, byteptr className)"
+    {
+        FuncBuilder f(context, FuncDef::builtin, voidptrType,
+                      "__CrackProfAlloc",
+                      2
+                      );
+        f.addArg("size", uintzType);
+        f.addArg("className", byteptrType);
+        f.setSymbolName("__CrackProfAlloc");
+        f.finish();
+    }
+
     // create "array[byteptr] __getArgv()"
     {
         TypeDefPtr array = context.ns->lookUp("array");
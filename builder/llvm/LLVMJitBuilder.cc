@@ -19,11 +19,13 @@
 #include "Utils.h"
 #include "BBuilderContextData.h"
 #include "debug/DebugTools.h"
+#include "debug/PerfMap.h"
 #include "Cacher.h"
 #include "spug/check.h"
 #include "spug/stlutil.h"
 #include "ModuleMerger.h"
 #include "Ops.h"
+#include "StackAlloc.h"
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/LinkAllPasses.h>
@@ -128,6 +130,9 @@ void LLVMJitBuilder::innerFinishModule(Context &context,
         passMan.add(llvm::createReassociatePass());
         // Eliminate Common SubExpressions.
         passMan.add(llvm::createGVNPass());
+        // Move non-escaping objects to the stack, looking up the bodies of
+        // functions from other modules in the merged module.
+        passMan.add(createStackAllocPass(getModuleMerger()->getTarget()));
         // Simplify the control flow graph (deleting unreachable blocks, etc).
         passMan.add(llvm::createCFGSimplificationPass());
 
@@ -183,6 +188,7 @@ namespace {
                                                 "", // filename
                                                 0 // line number
                                                 );
+                crack::debug::registerPerfSymbol(ptr, size, func.getName());
             }
     };
 
@@ -214,6 +220,10 @@ ExecutionEngine *LLVMJitBuilder::bindJitModule(Module *mod) {
 
             execEng = eb.create(tm);
             execEng->RegisterJITEventListener(&eventListener);
+            if (spug::contains(options->optionMap, "perfMap"))
+                crack::debug::enablePerfMap();
+            if (spug::contains(options->optionMap, "jitDump"))
+                crack::debug::enableJitDump();
             if (!spug::contains(options->optionMap, "nolazy"))
                 execEng->DisableLazyCompilation(false);
         }
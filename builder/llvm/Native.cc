@@ -17,6 +17,7 @@
  */
 
 #include "Native.h"
+#include "StackAlloc.h"
 #include "builder/BuilderOptions.h"
 
 #include <llvm/IR/LLVMContext.h>
@@ -464,6 +465,7 @@ void optimizeLink(llvm::Module *module, bool verify) {
 // priority.
 //    Passes.add(createLICMPass());      // Hoist loop invariants.
     Passes.add(createGVNPass());       // Remove redundancies.
+    Passes.add(createStackAllocPass()); // Non-escaping objects to the stack.
     Passes.add(createMemCpyOptPass()); // Remove dead memcpys.
 
     // Nuke dead stores.
@@ -0,0 +1,651 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "StackAlloc.h"
+
+#include <map>
+#include <vector>
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/CallSite.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include "spug/stlutil.h"
+
+using namespace llvm;
+using namespace std;
+
+namespace builder { namespace mvll {
+    const char *const CRACK_ALLOC_MD = "crack_alloc";
+}}
+
+using namespace builder::mvll;
+
+namespace {
+
+    // Maximum depth of the call graph that we'll explore when checking
+    // whether an argument escapes a function.
+    const int MAX_DEPTH = 8;
+
+    // Alignment of stack allocated objects, this matches what we get from
+    // malloc.
+    const unsigned OBJECT_ALIGNMENT = 16;
+
+    bool isReleaseFunc(Function *func) {
+        return func->getName().endswith(".oper release()");
+    }
+
+    bool isFreeCall(Instruction *inst) {
+        CallSite cs(inst);
+        if (!cs)
+            return false;
+        Function *callee = cs.getCalledFunction();
+        return callee && (callee->getName() == "free" ||
+                          callee->getName() == "__CrackFree"
+                          );
+    }
+
+    // Returns true if 'inst' adds an object to or removes it from the cycle
+    // collector's candidate buffer.  Stack objects never take part in
+    // cycles.
+    bool isCycleCandidateCall(Instruction *inst) {
+        CallSite cs(inst);
+        if (!cs)
+            return false;
+        Function *callee = cs.getCalledFunction();
+        return callee &&
+               (callee->getName() == "__CrackAddCycleCandidate" ||
+                callee->getName() == "__CrackRemoveCycleCandidate"
+                );
+    }
+
+    // Maps all of the globals used by 'func', which is defined in another
+    // module, to their counterparts in 'module', adding declarations for
+    // the ones that 'module' doesn't have yet.  Returns false if that isn't
+    // possible, i.e. if 'func' uses a global that is private to its module
+    // or 'module' has a global of the same name with a different type.
+    bool mapGlobals(Function *func, Module *module,
+                    ValueToValueMapTy &valueMap
+                    ) {
+        SmallVector<Value *, 16> workList;
+        SmallPtrSet<Value *, 16> visited;
+        for (Function::iterator block = func->begin();
+             block != func->end();
+             ++block
+             ) {
+            for (BasicBlock::iterator inst = block->begin();
+                 inst != block->end();
+                 ++inst
+                 ) {
+                for (User::op_iterator op = inst->op_begin();
+                     op != inst->op_end();
+                     ++op
+                     ) {
+                    if (isa<Constant>(*op))
+                        workList.push_back(*op);
+                }
+            }
+        }
+
+        while (!workList.empty()) {
+            Value *val = workList.pop_back_val();
+            if (!visited.insert(val))
+                continue;
+
+            if (GlobalValue *gval = dyn_cast<GlobalValue>(val)) {
+                if (gval->hasLocalLinkage())
+                    return false;
+
+                GlobalValue *dest;
+                if (Function *srcFunc = dyn_cast<Function>(gval)) {
+                    dest = module->getFunction(srcFunc->getName());
+                    if (!dest)
+                        dest = Function::Create(srcFunc->getFunctionType(),
+                                                GlobalValue::ExternalLinkage,
+                                                srcFunc->getName(),
+                                                module
+                                                );
+                } else if (GlobalVariable *srcVar =
+                            dyn_cast<GlobalVariable>(gval)
+                           ) {
+                    dest = module->getNamedGlobal(srcVar->getName());
+                    if (!dest)
+                        dest = new GlobalVariable(
+                            *module,
+                            srcVar->getType()->getElementType(),
+                            srcVar->isConstant(),
+                            GlobalValue::ExternalLinkage,
+                            0,
+                            srcVar->getName()
+                        );
+                } else {
+                    // aliases
+                    return false;
+                }
+
+                if (dest->getType() != gval->getType())
+                    return false;
+                valueMap[gval] = dest;
+            } else if (Constant *constant = dyn_cast<Constant>(val)) {
+                // constant expressions and aggregates can refer to globals.
+                for (User::op_iterator op = constant->op_begin();
+                     op != constant->op_end();
+                     ++op
+                     )
+                    workList.push_back(*op);
+            }
+        }
+        return true;
+    }
+
+    // Returns the size argument of an allocation, which is either a call to
+    // "__CrackAlloc(size)" or "calloc(count, size)".
+    Value *getAllocSize(CallInst *allocCall) {
+        return allocCall->getArgOperand(allocCall->getNumArgOperands() - 1);
+    }
+
+    class StackAllocPass : public ModulePass {
+        private:
+            typedef map<Argument *, bool> ArgResultMap;
+            typedef map<Function *, CallInst *> AllocatorMap;
+            typedef map<Function *, Function *> FuncMap;
+
+            // The module to look up the bodies of declared functions in (may
+            // be null).
+            const Module *library;
+
+            // Cached results for "does this argument escape its function?"
+            ArgResultMap argResults;
+
+            // Maps "oper new" functions to the call that allocates the object
+            // (or null if the function isn't an allocator that we can
+            // transform).
+            AllocatorMap allocators;
+
+            // Maps allocators and release functions to their stack-based
+            // counterparts.
+            FuncMap stackAllocators, stackReleases;
+
+            bool callEscapes(CallSite cs, Value *val,
+                             vector<CallSite> *releases,
+                             int depth
+                             );
+            bool valueEscapes(Value *root, bool allowReturn,
+                              vector<CallSite> *releases,
+                              int depth
+                              );
+            bool argEscapes(Function *func, unsigned argIndex, int depth);
+            Function *getBody(Function *func);
+            CallInst *getAllocation(Function *func);
+            Function *getStackAllocator(Function *allocator);
+            Function *getStackRelease(Function *release);
+            bool convertCall(Function &func, CallSite cs);
+
+        public:
+            static char ID;
+
+            StackAllocPass(const Module *library) :
+                ModulePass(ID),
+                library(library) {
+            }
+
+            virtual const char *getPassName() const {
+                return "Crack Stack Allocation";
+            }
+
+            virtual bool runOnModule(Module &module);
+    };
+
+    char StackAllocPass::ID = 0;
+
+    // Returns true if passing 'val' to the call site allows it to escape.
+    // If 'releases' is not null, calls to "oper release" are not
+    // considered escapes and are instead added to the vector.
+    bool StackAllocPass::callEscapes(CallSite cs, Value *val,
+                                     vector<CallSite> *releases,
+                                     int depth
+                                     ) {
+        // calling the value itself or calling an unknown function (this
+        // includes all virtual functions) is an escape.
+        if (cs.getCalledValue() == val)
+            return true;
+        Function *callee = cs.getCalledFunction();
+        if (!callee)
+            return true;
+
+        if (IntrinsicInst *intrinsic =
+             dyn_cast<IntrinsicInst>(cs.getInstruction())
+            ) {
+            switch (intrinsic->getIntrinsicID()) {
+                case Intrinsic::memset:
+                case Intrinsic::memcpy:
+                case Intrinsic::memmove:
+                case Intrinsic::dbg_declare:
+                case Intrinsic::dbg_value:
+                case Intrinsic::lifetime_start:
+                case Intrinsic::lifetime_end:
+                    return false;
+                default:
+                    return true;
+            }
+        }
+
+        if (releases && isReleaseFunc(callee)) {
+            releases->push_back(cs);
+            return false;
+        }
+
+        // we can't see into functions whose bodies we don't have.
+        Function *body = getBody(callee);
+        if (!body)
+            return true;
+
+        unsigned index = 0;
+        for (CallSite::arg_iterator arg = cs.arg_begin();
+             arg != cs.arg_end();
+             ++arg, ++index
+             ) {
+            if (*arg == val && argEscapes(body, index, depth + 1))
+                return true;
+        }
+        return false;
+    }
+
+    // Returns true if the pointer value 'root' (or any pointer derived from
+    // it) escapes the function that it's defined in.
+    bool StackAllocPass::valueEscapes(Value *root, bool allowReturn,
+                                      vector<CallSite> *releases,
+                                      int depth
+                                      ) {
+        SmallVector<Value *, 8> workList;
+        SmallPtrSet<Value *, 8> visited;
+        workList.push_back(root);
+        while (!workList.empty()) {
+            Value *val = workList.pop_back_val();
+            if (!visited.insert(val))
+                continue;
+
+            for (Value::use_iterator ui = val->use_begin();
+                 ui != val->use_end();
+                 ++ui
+                 ) {
+                Instruction *user = dyn_cast<Instruction>(*ui);
+                if (!user)
+                    return true;
+
+                switch (user->getOpcode()) {
+                    case Instruction::BitCast:
+                    case Instruction::GetElementPtr:
+                        workList.push_back(user);
+                        break;
+                    case Instruction::Load:
+                    case Instruction::ICmp:
+                        break;
+                    case Instruction::Store:
+                        // storing _to_ the object is fine, storing the
+                        // object anywhere is an escape.
+                        if (cast<StoreInst>(user)->getValueOperand() == val)
+                            return true;
+                        break;
+                    case Instruction::AtomicRMW:
+                        if (cast<AtomicRMWInst>(user)->getPointerOperand() !=
+                             val
+                            )
+                            return true;
+                        break;
+                    case Instruction::AtomicCmpXchg:
+                        if (cast<AtomicCmpXchgInst>(user)->
+                             getPointerOperand() != val
+                            )
+                            return true;
+                        break;
+                    case Instruction::Ret:
+                        if (!allowReturn)
+                            return true;
+                        break;
+                    case Instruction::Call:
+                    case Instruction::Invoke:
+                        if (callEscapes(CallSite(user), val, releases, depth))
+                            return true;
+                        break;
+                    default:
+                        // this includes phi nodes and selects: we don't try
+                        // to reason about a pointer once it's merged with
+                        // something else.
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool StackAllocPass::argEscapes(Function *func, unsigned argIndex,
+                                    int depth
+                                    ) {
+        if (depth > MAX_DEPTH)
+            return true;
+
+        Function::arg_iterator arg = func->arg_begin();
+        for (unsigned i = 0; i < argIndex; ++i)
+            ++arg;
+
+        Argument *argVal = &*arg;
+
+        ArgResultMap::iterator iter = argResults.find(argVal);
+        if (iter != argResults.end())
+            return iter->second;
+
+        // Assume the worst for recursive calls.  This is pessimistic, but it
+        // means that nothing we cache ever depends on an unproven
+        // assumption.
+        argResults[argVal] = true;
+        bool result = valueEscapes(argVal, false, 0, depth);
+        argResults[argVal] = result;
+        return result;
+    }
+
+    // Returns the definition of 'func', which may be in the library module
+    // if 'func' is only declared in the module we're working on.  Returns
+    // null if there's no definition that we can rely on.
+    Function *StackAllocPass::getBody(Function *func) {
+        if (func->isDeclaration() && library)
+            func = library->getFunction(func->getName());
+        if (!func || func->isDeclaration() || func->mayBeOverridden())
+            return 0;
+        return func;
+    }
+
+    // If 'func' is an allocator that we can convert to stack allocation,
+    // returns its allocation call.  Returns null if not.
+    CallInst *StackAllocPass::getAllocation(Function *func) {
+        AllocatorMap::iterator iter = allocators.find(func);
+        if (iter != allocators.end())
+            return iter->second;
+
+        CallInst *result = 0;
+        if (!func->isDeclaration() && !func->mayBeOverridden()) {
+            int allocCount = 0;
+            for (Function::iterator block = func->begin();
+                 block != func->end();
+                 ++block
+                 ) {
+                for (BasicBlock::iterator inst = block->begin();
+                     inst != block->end();
+                     ++inst
+                     ) {
+                    CallInst *call = dyn_cast<CallInst>(inst);
+                    if (call && call->getMetadata(CRACK_ALLOC_MD)) {
+                        result = call;
+                        ++allocCount;
+                    }
+                }
+            }
+
+            // We need exactly one allocation of a single object of constant
+            // size.
+            if (allocCount != 1) {
+                result = 0;
+            } else {
+                if (result->getNumArgOperands() == 2) {
+                    ConstantInt *count =
+                        dyn_cast<ConstantInt>(result->getArgOperand(0));
+                    if (!count || !count->isOne())
+                        result = 0;
+                }
+                if (result && !isa<Constant>(getAllocSize(result)))
+                    result = 0;
+            }
+
+            // Make sure the object doesn't escape other than by being
+            // returned, and that it's the only thing that gets returned.
+            if (result && valueEscapes(result, true, 0, 0))
+                result = 0;
+            if (result) {
+                for (Function::iterator block = func->begin();
+                     block != func->end();
+                     ++block
+                     ) {
+                    ReturnInst *ret = dyn_cast<ReturnInst>(
+                        block->getTerminator()
+                    );
+                    if (ret && (!ret->getReturnValue() ||
+                                ret->getReturnValue()->stripPointerCasts() !=
+                                 result
+                                )
+                        ) {
+                        result = 0;
+                        break;
+                    }
+                }
+            }
+        }
+
+        allocators[func] = result;
+        return result;
+    }
+
+    // Returns a version of the allocator that constructs the object in
+    // memory passed in as the first argument.
+    Function *StackAllocPass::getStackAllocator(Function *allocator) {
+        FuncMap::iterator iter = stackAllocators.find(allocator);
+        if (iter != stackAllocators.end())
+            return iter->second;
+
+        LLVMContext &lctx = allocator->getContext();
+        FunctionType *orgType = allocator->getFunctionType();
+        vector<Type *> argTypes;
+        argTypes.push_back(Type::getInt8PtrTy(lctx));
+        argTypes.insert(argTypes.end(), orgType->param_begin(),
+                        orgType->param_end()
+                        );
+        FunctionType *funcType =
+            FunctionType::get(orgType->getReturnType(), argTypes, false);
+        Function *result = Function::Create(funcType,
+                                            GlobalValue::InternalLinkage,
+                                            allocator->getName() + ":stack",
+                                            allocator->getParent()
+                                            );
+        result->setCallingConv(allocator->getCallingConv());
+
+        // map the original arguments to all but the first argument of the
+        // new function.
+        ValueToValueMapTy valueMap;
+        Function::arg_iterator destArg = result->arg_begin();
+        Argument *mem = destArg++;
+        mem->setName("mem");
+        for (Function::arg_iterator arg = allocator->arg_begin();
+             arg != allocator->arg_end();
+             ++arg, ++destArg
+             ) {
+            destArg->setName(arg->getName());
+            valueMap[arg] = destArg;
+        }
+
+        SmallVector<ReturnInst *, 8> returns;
+        CloneFunctionInto(result, allocator, valueMap, false, returns, "");
+
+        // replace the allocation with a memset() of the memory we've been
+        // given (the stack slot may be reused, so we still need to zero it).
+        CallInst *allocCall =
+            cast<CallInst>(static_cast<Value *>(
+                valueMap[getAllocation(allocator)]
+            ));
+        IRBuilder<> builder(allocCall);
+        builder.CreateMemSet(mem, builder.getInt8(0),
+                             getAllocSize(allocCall),
+                             OBJECT_ALIGNMENT
+                             );
+        allocCall->replaceAllUsesWith(
+            builder.CreateBitCast(mem, allocCall->getType())
+        );
+        allocCall->eraseFromParent();
+
+        stackAllocators[allocator] = result;
+        return result;
+    }
+
+    // Returns a version of the release function that doesn't free the
+    // object, returns null if the function body isn't available.
+    Function *StackAllocPass::getStackRelease(Function *release) {
+        FuncMap::iterator iter = stackReleases.find(release);
+        if (iter != stackReleases.end())
+            return iter->second;
+
+        Function *result = 0;
+        Function *body = getBody(release);
+        Module *module = release->getParent();
+        ValueToValueMapTy valueMap;
+        bool external = body && body->getParent() != module;
+        if (body && body->getFunctionType() == release->getFunctionType() &&
+            (!external || mapGlobals(body, module, valueMap))
+            ) {
+            result = CloneFunction(body, valueMap, external);
+            result->setName(release->getName() + ":stack");
+            result->setLinkage(GlobalValue::InternalLinkage);
+            module->getFunctionList().push_back(result);
+
+            // remove all calls to free() and __CrackFree() and all cycle
+            // collector bookkeeping.
+            vector<Instruction *> frees;
+            for (Function::iterator block = result->begin();
+                 block != result->end();
+                 ++block
+                 ) {
+                for (BasicBlock::iterator inst = block->begin();
+                     inst != block->end();
+                     ++inst
+                     ) {
+                    if (isFreeCall(inst) || isCycleCandidateCall(inst))
+                        frees.push_back(inst);
+                }
+            }
+            SPUG_FOR(vector<Instruction *>, inst, frees) {
+                if (InvokeInst *invoke = dyn_cast<InvokeInst>(*inst))
+                    BranchInst::Create(invoke->getNormalDest(), invoke);
+                (*inst)->eraseFromParent();
+            }
+        }
+
+        stackReleases[release] = result;
+        return result;
+    }
+
+    // Try to convert the allocator call 'cs' in 'func' to a stack
+    // allocation.  Returns true if the call was converted.
+    bool StackAllocPass::convertCall(Function &func, CallSite cs) {
+        Function *allocator = cs.getCalledFunction();
+        CallInst *allocCall;
+        if (!allocator || !(allocCall = getAllocation(allocator)))
+            return false;
+
+        // make sure the object doesn't escape from the caller.
+        vector<CallSite> releases;
+        if (valueEscapes(cs.getInstruction(), false, &releases, 0))
+            return false;
+
+        // make sure we can get non-freeing versions of all release functions.
+        vector<Function *> newReleases;
+        SPUG_FOR(vector<CallSite>, release, releases) {
+            Function *newRelease =
+                getStackRelease(release->getCalledFunction());
+            if (!newRelease)
+                return false;
+            newReleases.push_back(newRelease);
+        }
+
+        // Allocate the object at the start of the function.
+        Instruction *inst = cs.getInstruction();
+        BasicBlock &entry = func.getEntryBlock();
+        AllocaInst *mem =
+            new AllocaInst(Type::getInt8Ty(func.getContext()),
+                           getAllocSize(allocCall),
+                           OBJECT_ALIGNMENT,
+                           "stackobj",
+                           &*entry.getFirstInsertionPt()
+                           );
+
+        // Replace the call to the allocator with a call to the in-place
+        // allocator.
+        vector<Value *> args;
+        args.push_back(mem);
+        args.insert(args.end(), cs.arg_begin(), cs.arg_end());
+        Function *stackAllocator = getStackAllocator(allocator);
+        Instruction *newInst;
+        if (InvokeInst *invoke = dyn_cast<InvokeInst>(inst))
+            newInst = InvokeInst::Create(stackAllocator,
+                                         invoke->getNormalDest(),
+                                         invoke->getUnwindDest(),
+                                         args,
+                                         "",
+                                         inst
+                                         );
+        else
+            newInst = CallInst::Create(stackAllocator, args, "", inst);
+        CallSite(newInst).setCallingConv(cs.getCallingConv());
+        newInst->takeName(inst);
+        inst->replaceAllUsesWith(newInst);
+        inst->eraseFromParent();
+
+        // redirect all releases to the non-freeing versions.
+        for (unsigned i = 0; i < releases.size(); ++i)
+            releases[i].setCalledFunction(newReleases[i]);
+
+        return true;
+    }
+
+    bool StackAllocPass::runOnModule(Module &module) {
+        bool changed = false;
+        vector<Function *> funcs;
+        for (Module::iterator func = module.begin(); func != module.end();
+             ++func
+             ) {
+            if (!func->isDeclaration())
+                funcs.push_back(func);
+        }
+
+        SPUG_FOR(vector<Function *>, func, funcs) {
+            // collect call sites first, converting them invalidates the
+            // iterators.
+            vector<Instruction *> calls;
+            for (Function::iterator block = (*func)->begin();
+                 block != (*func)->end();
+                 ++block
+                 ) {
+                for (BasicBlock::iterator inst = block->begin();
+                     inst != block->end();
+                     ++inst
+                     ) {
+                    CallSite cs(&*inst);
+                    if (cs && cs.getCalledFunction() &&
+                        cs.getCalledFunction()->getName().find(".oper new(") !=
+                         StringRef::npos
+                        )
+                        calls.push_back(inst);
+                }
+            }
+
+            SPUG_FOR(vector<Instruction *>, inst, calls)
+                changed |= convertCall(**func, CallSite(*inst));
+        }
+        return changed;
+    }
+}
+
+ModulePass *builder::mvll::createStackAllocPass(const Module *library) {
+    return new StackAllocPass(library);
+}
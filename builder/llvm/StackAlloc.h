@@ -0,0 +1,51 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#ifndef _builder_llvm_StackAlloc_h_
+#define _builder_llvm_StackAlloc_h_
+
+namespace llvm {
+    class Module;
+    class ModulePass;
+}
+
+namespace builder { namespace mvll {
+
+// The name of the metadata node that LLVMBuilder::emitAlloc() attaches to
+// the "__CrackAlloc" or "calloc" call of a single object allocation.  The
+// stack allocation pass uses it to identify allocators ("oper new"
+// functions).
+extern const char *const CRACK_ALLOC_MD;
+
+// Creates a module pass that moves non-escaping object allocations onto the
+// stack.
+//
+// The pass looks for calls to "oper new" functions whose result does not
+// escape the calling function.  An object escapes if a pointer to it is
+// stored anywhere, returned, passed to a function whose body isn't visible
+// to the pass, or called through a function pointer (i.e. virtual
+// functions).  Calls to "oper release" are the one exception: the releases
+// of a stack allocated object are redirected to a clone of the release
+// function that runs "oper del" but doesn't free the memory.
+//
+// For each qualifying call site, the allocation is replaced by an "alloca"
+// in the entry block of the caller and "oper new" is replaced by a clone that
+// constructs the object in the memory passed in as its first argument.
+//
+// Since it requires function bodies for the entire call graph of the object,
+// the pass needs to see the definitions of the functions that the module only
+// declares.  When compiling to native code, all modules are linked together
+// prior to optimization so everything is visible.  In the JIT, 'library' is
+// the module that all previously compiled modules have been merged into: the
+// pass looks up the bodies of declared functions there, and clones the
+// release functions that it needs (e.g. Object.oper release()) into the
+// module being compiled.
+llvm::ModulePass *createStackAllocPass(const llvm::Module *library = 0);
+
+}} // namespace builder::mvll
+
+#endif
@@ -0,0 +1,169 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Support for perf map and jitdump files.  See
+// tools/perf/Documentation/jitdump-specification.txt in the linux sources
+// for the jitdump format.
+
+#include "PerfMap.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <elf.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+    FILE *perfMap;
+
+#ifdef __linux__
+    FILE *jitDump;
+    uint64_t codeIndex;
+
+    const uint32_t JITDUMP_MAGIC = 0x4A695444;
+    const uint32_t JITDUMP_VERSION = 1;
+    const uint32_t JIT_CODE_LOAD = 0;
+
+    struct JitDumpHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t totalSize;
+        uint32_t elfMach;
+        uint32_t pad1;
+        uint32_t pid;
+        uint64_t timestamp;
+        uint64_t flags;
+    };
+
+    struct JitRecordHeader {
+        uint32_t id;
+        uint32_t totalSize;
+        uint64_t timestamp;
+    };
+
+    struct JitCodeLoad {
+        JitRecordHeader header;
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t vma;
+        uint64_t codeAddr;
+        uint64_t codeSize;
+        uint64_t codeIndex;
+    };
+
+    uint32_t getElfMach() {
+#if defined(__x86_64__)
+        return EM_X86_64;
+#elif defined(__i386__)
+        return EM_386;
+#elif defined(__aarch64__)
+        return EM_AARCH64;
+#elif defined(__arm__)
+        return EM_ARM;
+#else
+        return EM_NONE;
+#endif
+    }
+
+    // perf requires timestamps from the monotonic clock.
+    uint64_t getTimestamp() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+#endif
+
+} // anonymous namespace
+
+void crack::debug::enablePerfMap() {
+    if (perfMap)
+        return;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/tmp/perf-%d.map", getpid());
+    perfMap = fopen(name, "w");
+}
+
+void crack::debug::enableJitDump() {
+#ifdef __linux__
+    if (jitDump)
+        return;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/tmp/jit-%d.dump", getpid());
+    int fd = open(name, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd == -1)
+        return;
+
+    // perf finds the dump file by looking for an executable mapping of it
+    // in the process, so we have to map it even though we don't use the
+    // mapping.
+    void *marker = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC,
+                        MAP_PRIVATE,
+                        fd,
+                        0
+                        );
+    if (marker == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+
+    jitDump = fdopen(fd, "w+");
+    if (!jitDump)
+        return;
+
+    JitDumpHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.totalSize = sizeof(header);
+    header.elfMach = getElfMach();
+    header.pid = getpid();
+    header.timestamp = getTimestamp();
+    fwrite(&header, sizeof(header), 1, jitDump);
+    fflush(jitDump);
+#endif
+}
+
+void crack::debug::registerPerfSymbol(void *address, size_t size,
+                                      const string &name
+                                      ) {
+    if (perfMap) {
+        fprintf(perfMap, "%lx %lx %s\n",
+                reinterpret_cast<unsigned long>(address),
+                static_cast<unsigned long>(size),
+                name.c_str()
+                );
+        fflush(perfMap);
+    }
+
+#ifdef __linux__
+    if (jitDump) {
+        JitCodeLoad record;
+        record.header.id = JIT_CODE_LOAD;
+        record.header.totalSize = sizeof(record) + name.size() + 1 + size;
+        record.header.timestamp = getTimestamp();
+        record.pid = getpid();
+        record.tid = syscall(SYS_gettid);
+        record.vma = record.codeAddr = reinterpret_cast<uint64_t>(address);
+        record.codeSize = size;
+        record.codeIndex = codeIndex++;
+        fwrite(&record, sizeof(record), 1, jitDump);
+        fwrite(name.c_str(), name.size() + 1, 1, jitDump);
+        fwrite(address, size, 1, jitDump);
+        fflush(jitDump);
+    }
+#endif
+}
@@ -0,0 +1,38 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#ifndef _crack_debug_PerfMap_h_
+#define _crack_debug_PerfMap_h_
+
+#include <stddef.h>
+#include <string>
+
+namespace crack { namespace debug {
+
+/**
+ * Start writing JIT symbols to /tmp/perf-<pid>.map, the file that the linux
+ * "perf" tool reads to symbolize samples in anonymous memory.
+ */
+void enablePerfMap();
+
+/**
+ * Start writing JIT symbols and code to a jitdump file
+ * (/tmp/jit-<pid>.dump).  Use "perf record -k 1" and "perf inject --jit" to
+ * attribute samples to jitted functions with it.  This is only supported on
+ * linux.
+ */
+void enableJitDump();
+
+/**
+ * Record a jitted function in the perf map and jitdump files if they are
+ * enabled.
+ */
+void registerPerfSymbol(void *address, size_t size, const std::string &name);
+
+}} // namespace crack::debug
+
+#endif
@@ -921,6 +921,17 @@ void Context::expandIteration(const std::string &name, bool defineVar,
                             " does not have an 'elem()' method."
                             )
                   );
+
+        // The loop variable is assigned right after the condition has
+        // verified the iterator, so if the iterator provides an
+        // "uncheckedElem()" method that doesn't redo that check, use it
+        // instead.
+        FuncDefPtr uncheckedFunc =
+            lookUpNoArgs("uncheckedElem", true, iterCall->type.get());
+        if (uncheckedFunc &&
+            uncheckedFunc->returnType->matches(*elemFunc->returnType)
+            )
+            elemFunc = uncheckedFunc;
                             
         
         if (defineVar) {
@@ -79,6 +79,14 @@ void crack_ext__pthread_cinit(crack::ext::Module *mod) {
     crack::ext::Type *type_pthread_condattr_t = mod->addType("pthread_condattr_t", sizeof(pthread_condattr_t));
     type_pthread_condattr_t->finish();
 
+
+    crack::ext::Type *type_pthread_rwlock_t = mod->addType("pthread_rwlock_t", sizeof(pthread_rwlock_t));
+    type_pthread_rwlock_t->finish();
+
+
+    crack::ext::Type *type_pthread_rwlockattr_t = mod->addType("pthread_rwlockattr_t", sizeof(pthread_rwlockattr_t));
+    type_pthread_rwlockattr_t->finish();
+
     f = mod->addFunc(type_int, "pthread_create",
                      (void *)pthread_create
                      );
@@ -146,4 +154,30 @@ void crack_ext__pthread_cinit(crack::ext::Module *mod) {
        f->addArg(type_pthread_cond_t, "cond");
        f->addArg(type_pthread_mutex_t, "mutex");
 
+    f = mod->addFunc(type_int, "pthread_rwlock_init",
+                     (void *)pthread_rwlock_init
+                     );
+       f->addArg(type_pthread_rwlock_t, "lock");
+       f->addArg(type_pthread_rwlockattr_t, "attrs");
+
+    f = mod->addFunc(type_int, "pthread_rwlock_destroy",
+                     (void *)pthread_rwlock_destroy
+                     );
+       f->addArg(type_pthread_rwlock_t, "lock");
+
+    f = mod->addFunc(type_int, "pthread_rwlock_rdlock",
+                     (void *)pthread_rwlock_rdlock
+                     );
+       f->addArg(type_pthread_rwlock_t, "lock");
+
+    f = mod->addFunc(type_int, "pthread_rwlock_wrlock",
+                     (void *)pthread_rwlock_wrlock
+                     );
+       f->addArg(type_pthread_rwlock_t, "lock");
+
+    f = mod->addFunc(type_int, "pthread_rwlock_unlock",
+                     (void *)pthread_rwlock_unlock
+                     );
+       f->addArg(type_pthread_rwlock_t, "lock");
+
 }
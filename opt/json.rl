@@ -24,9 +24,10 @@ import crack.cont.array Array;
 import crack.lang AppendBuffer, Buffer, CString, ManagedBuffer;
 import crack.enc.json.lib JsonObject, JsonArray, JsonInt, JsonFloat, JsonBool, 
     JsonString, UnexpectedToken, ParseException;
-import crack.math atoi, INFINITY, NAN, strtof, fpclassify, FP_INFINITE, FP_NAN,
+import crack.math atoi, INFINITY, NAN, fpclassify, FP_INFINITE, FP_NAN,
     FP_NORMAL, FP_ZERO, sign;
 import crack.io Formatter, FStr, cerr;
+import crack.runtime parseFloat32;
 @import crack.ann define;
 
 class JsonParser {
@@ -319,7 +320,7 @@ class JsonParser {
             return null;
         }
 
-        JsonFloat number = { strtof(CString(data + uintz(memo), p - memo, false)) };
+        JsonFloat number = { parseFloat32(data + uintz(memo), uint(p - memo)) };
         return ParserResult(number, p + 1);
     }
 
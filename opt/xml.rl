@@ -28,7 +28,8 @@ import crack.cont.list List;
 import crack.exp.file File;
 import crack.io FStr, cout, cerr, StringFormatter, Reader, StringWriter;
 import crack.lang AppendBuffer, InvalidResourceError, Buffer, Formatter,
-                  WriteBuffer, Exception, IndexError, KeyError, CString;
+                  WriteBuffer, Exception, IndexError, KeyError, CString,
+                  RefVisitor;
 import crack.math min, strtof;
 import crack.runtime memmove, mmap, munmap, Stat, fopen, PROT_READ, MAP_PRIVATE,
                     stat, fileno;
@@ -169,6 +170,18 @@ class Element {
         return _parent;
     }
 
+    /// Visits the parent and the child list for the cycle collector.
+    void traverseRefs(RefVisitor visitor) {
+        visitor.visit(_children);
+        visitor.visit(_parent);
+    }
+
+    /// Drops the parent and the children, breaking the cycles between them.
+    void clearRefs() {
+        _children = null;
+        _parent = null;
+    }
+
     /// @param name the name of the child {@link Element}
     /// @return the first child having the given name or null, does not recurse
     Element getChildByName(String name) {
@@ -689,6 +689,63 @@ namespace {
       context->maybeExplainOverload(msg, funcName, ns);
       context->error(msg.str());
    }
+
+   // Returns an estimate of the number of bytes that formatting a value of 
+   // the given type will produce.  The numeric estimates are the maximum 
+   // length of the decimal representation.
+   unsigned int estimateFormattedSize(Context *context, TypeDef *type) {
+      Construct *construct = context->construct;
+      if (type == construct->int16Type.get())
+         return 6;
+      else if (type == construct->uint16Type.get())
+         return 5;
+      else if (type == construct->int32Type.get() ||
+               type == construct->intType.get()
+               )
+         return 11;
+      else if (type == construct->uint32Type.get() ||
+               type == construct->uintType.get()
+               )
+         return 10;
+      else if (type == construct->int64Type.get() ||
+               type == construct->intzType.get()
+               )
+         return 21;
+      else if (type == construct->uint64Type.get() ||
+               type == construct->uintzType.get()
+               )
+         return 20;
+      else if (type == construct->float32Type.get() ||
+               type == construct->float64Type.get() ||
+               type == construct->floatType.get()
+               )
+         return 24;
+      else if (type == construct->boolType.get())
+         return 5;
+      else
+         return 16;
+   }
+
+   // Creates a call to a formatter method.  If the exact type of the 
+   // formatter is known ('exactType' is non-null) and the method is virtual, 
+   // the call goes directly to the implementation for that type.
+   FuncCallPtr createFormatterCall(Context *context, FuncDef *func,
+                                   TypeDef *exactType
+                                   ) {
+      bool squashVirtual = false;
+      if (exactType && (func->flags & FuncDef::virtualized)) {
+         OverloadDef *overloads =
+            OverloadDefPtr::rcast(exactType->lookUp(func->name));
+         FuncDef *impl = overloads ? overloads->getSigMatch(func->args) : 0;
+         if (impl && !(impl->flags & FuncDef::abstract)) {
+            func = impl;
+            squashVirtual = true;
+         }
+      }
+
+      StatState s1(context, ConstructStats::builder);
+      return context->builder.createFuncCall(func, squashVirtual);
+   }
 }
 
 // ` ... `
@@ -700,58 +757,84 @@ ExprPtr Parser::parseIString(Expr *expr) {
    GetRegisterExprPtr reg = new GetRegisterExpr(expr->type.get());
    ExprPtr formatter = new SetRegisterExpr(reg.get(), expr);
    
-   // create an expression sequence for the formatter
-   MultiExprPtr seq = new MultiExpr();
-   
-   // look up an "enter()" function
-   FuncDefPtr func = context->lookUpNoArgs("enter", true, expr->type.get());
-   if (func) {
-      BSTATS_GO(s1)
-      FuncCallPtr funcCall = context->builder.createFuncCall(func.get());
-      BSTATS_END
-      if (func->flags & FuncDef::method)
-         funcCall->receiver = reg;
-      seq->add(funcCall.get());
-   }
+   // if the formatter is being constructed right here, we know its exact 
+   // type and can bypass virtual dispatch.
+   TypeDef *exactType = 0;
+   FuncCall *ctorCall = FuncCallPtr::cast(expr);
+   if (ctorCall && ctorCall->func->name == "oper new" &&
+       ctorCall->func->getOwner() == expr->type.get()
+       )
+      exactType = expr->type.get();
 
-   // parse all of the subtokens
+   // parse all of the subtokens, estimating the size of the result as we go.
+   vector< pair<ExprPtr, Token> > segments;
+   unsigned int sizeHint = 0;
    Token tok;
    while (!(tok = getToken()).isIstrEnd()) {
       ExprPtr arg;
       if (tok.isString()) {
           if (tok.getData().size() == 0) continue;
           arg = context->getStrConst(tok.getData());
+          sizeHint += tok.getData().size();
       } else if (tok.isIdent()) {
          // get a variable definition
          arg = createVarRef(0, tok);
          toker.continueIString();
+         sizeHint += estimateFormattedSize(context.get(), arg->type.get());
       } else if (tok.isLParen()) {
          arg = parseExpression();
          tok = getToken();
          if (!tok.isRParen())
             unexpected(tok, "expected a right paren");
          toker.continueIString();
+         sizeHint += estimateFormattedSize(context.get(), arg->type.get());
       } else {
          unexpected(tok, 
                     "expected an identifer or a parenthesized expression "
                      "after the $ in an interpolated string"
                     );
       }
+      segments.push_back(make_pair(arg, tok));
+   }
 
+   // create an expression sequence for the formatter
+   MultiExprPtr seq = new MultiExpr();
+   
+   // look up an "enter(uint sizeHint)" function, falling back to "enter()"
+   FuncCall::ExprVec hintArgs(1);
+   hintArgs[0] = context->builder.createUIntConst(
+      *context, 
+      sizeHint, 
+      context->construct->uintType.get()
+   );
+   FuncDefPtr func = context->lookUp("enter", hintArgs, expr->type.get());
+   if (!func) {
+      hintArgs.clear();
+      func = context->lookUpNoArgs("enter", true, expr->type.get());
+   }
+   if (func) {
+      FuncCallPtr funcCall = 
+         createFormatterCall(context.get(), func.get(), exactType);
+      funcCall->args = hintArgs;
+      if (func->flags & FuncDef::method)
+         funcCall->receiver = reg;
+      seq->add(funcCall.get());
+   }
+
+   for (size_t i = 0; i < segments.size(); ++i) {
       // look up a format method for the argument
       FuncCall::ExprVec args(1);
-      args[0] = arg;
+      args[0] = segments[i].first;
       func = context->lookUp("format", args, expr->type.get());
       if (!func)
-         error(tok, 
+         error(segments[i].second, 
                SPUG_FSTR("No format method exists for objects of type " <<
-                         arg->type->getDisplayName()
+                         args[0]->type->getDisplayName()
                          )
                );
       
-      BSTATS_GO(s1)
-      FuncCallPtr funcCall = context->builder.createFuncCall(func.get());
-      BSTATS_END
+      FuncCallPtr funcCall = 
+         createFormatterCall(context.get(), func.get(), exactType);
       funcCall->args = args;
       if (func->flags & FuncDef::method)
          funcCall->receiver = reg;
@@ -760,9 +843,8 @@ ExprPtr Parser::parseIString(Expr *expr) {
 
    func = context->lookUpNoArgs("leave", true, expr->type.get());
    if (func) {
-      BSTATS_GO(s1)
-      FuncCallPtr funcCall = context->builder.createFuncCall(func.get());
-      BSTATS_END
+      FuncCallPtr funcCall = 
+         createFormatterCall(context.get(), func.get(), exactType);
       if (func->flags & FuncDef::method)
          funcCall->receiver = reg;
       seq->add(funcCall.get());
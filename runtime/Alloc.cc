@@ -0,0 +1,325 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Size class allocator for Crack objects.
+//
+// Small objects are allocated from per-thread free lists, one for each size
+// class.  When a thread's list for a class is empty, we take a batch of
+// blocks from the central free list for the class (allocating a new chunk if
+// that's empty too) and when it grows beyond twice the batch size we return a
+// batch to the central list.  The central lists are protected by a single
+// lock, which we only touch once per batch.
+//
+// Every block is preceded by a header containing its size class so that
+// __CrackFree() doesn't need to know the size of the object.  This is no
+// more overhead than we'd pay for a malloc() chunk header.  Objects too large
+// for the small classes are allocated from malloc() with the same header.
+//
+// Chunks are never returned to the system.
+
+#include "Alloc.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AllocProfiler.h"
+
+using namespace crack::runtime;
+
+namespace {
+
+    // Object sizes are rounded up to a multiple of this, it is also the
+    // alignment of all objects.
+    const size_t GRANULARITY = 16;
+
+    // The number of small object classes.  Objects larger than
+    // SMALL_CLASSES * GRANULARITY go into LARGE_CLASS.
+    const unsigned SMALL_CLASSES = 32;
+    const unsigned LARGE_CLASS = SMALL_CLASSES;
+    const unsigned CLASS_COUNT = SMALL_CLASSES + 1;
+
+    // Number of blocks moved between a thread cache and the central list at
+    // a time.
+    const unsigned BATCH_SIZE = 32;
+
+    // Size of the chunks that we carve small blocks out of.
+    const size_t CHUNK_SIZE = 64 * 1024;
+
+    union BlockHeader {
+        unsigned sizeClass;
+        char padding[GRANULARITY];
+    };
+
+    // Free blocks are linked through the object area of the block.
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct CentralList {
+        FreeBlock *head;
+
+        // Stats from threads that have terminated.
+        uint64_t allocs, frees;
+    };
+
+    struct ClassCache {
+        FreeBlock *head;
+        unsigned count;
+        uint64_t allocs, frees;
+    };
+
+    struct ThreadCache {
+        ClassCache classes[CLASS_COUNT];
+
+        // Links in the list of all thread caches (for stats).
+        ThreadCache *next, *prev;
+    };
+
+    int selectAllocator() {
+        const char *name = getenv("CRACK_ALLOCATOR");
+        if (name && !strcmp(name, "libc"))
+            return libcAllocator;
+        return sizeClassAllocator;
+    }
+
+    // This has to be decided before the first allocation and never changed,
+    // so we do it when the runtime is loaded.
+    const int allocatorType = selectAllocator();
+
+    // Protects the central lists and the thread cache list.
+    pthread_mutex_t centralLock = PTHREAD_MUTEX_INITIALIZER;
+    CentralList centralLists[CLASS_COUNT];
+    ThreadCache *threadCaches;
+
+    pthread_key_t threadCacheKey;
+    pthread_once_t threadCacheKeyOnce = PTHREAD_ONCE_INIT;
+    __thread ThreadCache *threadCache;
+
+    inline size_t getObjectSize(unsigned sizeClass) {
+        return (sizeClass + 1) * GRANULARITY;
+    }
+
+    inline unsigned getSizeClass(size_t size) {
+        if (!size)
+            return 0;
+        size_t sizeClass = (size - 1) / GRANULARITY;
+        return sizeClass < SMALL_CLASSES ? sizeClass : LARGE_CLASS;
+    }
+
+    // Move 'count' blocks from the cache to the central list.  Caller must
+    // hold the central lock.
+    void flush(ClassCache &cache, CentralList &central, unsigned count) {
+        while (count-- && cache.head) {
+            FreeBlock *block = cache.head;
+            cache.head = block->next;
+            block->next = central.head;
+            central.head = block;
+            --cache.count;
+        }
+    }
+
+    // Called when a thread terminates: give its blocks and stats back to the
+    // central lists.
+    void releaseThreadCache(void *arg) {
+        ThreadCache *cache = static_cast<ThreadCache *>(arg);
+        pthread_mutex_lock(&centralLock);
+        for (unsigned i = 0; i < CLASS_COUNT; ++i) {
+            ClassCache &classCache = cache->classes[i];
+            CentralList &central = centralLists[i];
+            flush(classCache, central, classCache.count);
+            central.allocs += classCache.allocs;
+            central.frees += classCache.frees;
+        }
+
+        if (cache->prev)
+            cache->prev->next = cache->next;
+        else
+            threadCaches = cache->next;
+        if (cache->next)
+            cache->next->prev = cache->prev;
+        pthread_mutex_unlock(&centralLock);
+
+        free(cache);
+        threadCache = 0;
+    }
+
+    void initThreadCacheKey() {
+        int rc = pthread_key_create(&threadCacheKey, releaseThreadCache);
+        assert(rc == 0 && "Unable to create pthread key for thread cache.");
+    }
+
+    ThreadCache *createThreadCache() {
+        pthread_once(&threadCacheKeyOnce, initThreadCacheKey);
+        ThreadCache *cache =
+            static_cast<ThreadCache *>(calloc(1, sizeof(ThreadCache)));
+        if (!cache)
+            return 0;
+
+        pthread_mutex_lock(&centralLock);
+        cache->next = threadCaches;
+        if (threadCaches)
+            threadCaches->prev = cache;
+        threadCaches = cache;
+        pthread_mutex_unlock(&centralLock);
+
+        pthread_setspecific(threadCacheKey, cache);
+        return cache;
+    }
+
+    inline ThreadCache *getThreadCache() {
+        if (!threadCache)
+            threadCache = createThreadCache();
+        return threadCache;
+    }
+
+    // Fill an empty class cache from the central list, allocating a new
+    // chunk if necessary.  Returns false if we're out of memory.
+    bool refill(ClassCache &cache, unsigned sizeClass) {
+        CentralList &central = centralLists[sizeClass];
+        pthread_mutex_lock(&centralLock);
+        if (!central.head) {
+            size_t blockSize = sizeof(BlockHeader) + getObjectSize(sizeClass);
+            char *chunk = static_cast<char *>(malloc(CHUNK_SIZE));
+            if (!chunk) {
+                pthread_mutex_unlock(&centralLock);
+                return false;
+            }
+
+            for (char *cur = chunk; cur + blockSize <= chunk + CHUNK_SIZE;
+                 cur += blockSize
+                 ) {
+                BlockHeader *header = reinterpret_cast<BlockHeader *>(cur);
+                header->sizeClass = sizeClass;
+                FreeBlock *block = reinterpret_cast<FreeBlock *>(header + 1);
+                block->next = central.head;
+                central.head = block;
+            }
+        }
+
+        for (unsigned i = 0; i < BATCH_SIZE && central.head; ++i) {
+            FreeBlock *block = central.head;
+            central.head = block->next;
+            block->next = cache.head;
+            cache.head = block;
+            ++cache.count;
+        }
+        pthread_mutex_unlock(&centralLock);
+        return true;
+    }
+
+    uint64_t sumCounts(unsigned sizeClass, bool allocs) {
+        if (sizeClass >= CLASS_COUNT)
+            return 0;
+        pthread_mutex_lock(&centralLock);
+        const CentralList &central = centralLists[sizeClass];
+        uint64_t result = allocs ? central.allocs : central.frees;
+        for (ThreadCache *cache = threadCaches; cache; cache = cache->next) {
+            const ClassCache &classCache = cache->classes[sizeClass];
+            result += allocs ? classCache.allocs : classCache.frees;
+        }
+        pthread_mutex_unlock(&centralLock);
+        return result;
+    }
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+int getAllocatorType() {
+    return allocatorType;
+}
+
+unsigned getAllocClassCount() {
+    return CLASS_COUNT;
+}
+
+size_t getAllocClassSize(unsigned sizeClass) {
+    if (sizeClass >= LARGE_CLASS)
+        return static_cast<size_t>(-1);
+    return getObjectSize(sizeClass);
+}
+
+uint64_t getAllocCount(unsigned sizeClass) {
+    return sumCounts(sizeClass, true);
+}
+
+uint64_t getFreeCount(unsigned sizeClass) {
+    return sumCounts(sizeClass, false);
+}
+
+}} // namespace crack::runtime
+
+extern "C" void *__CrackAlloc(size_t size) {
+    if (allocatorType == libcAllocator)
+        return calloc(1, size);
+
+    ThreadCache *cache = getThreadCache();
+    if (!cache)
+        return 0;
+
+    unsigned sizeClass = getSizeClass(size);
+    ClassCache &classCache = cache->classes[sizeClass];
+    if (sizeClass == LARGE_CLASS) {
+        BlockHeader *header = static_cast<BlockHeader *>(
+            calloc(1, sizeof(BlockHeader) + size)
+        );
+        if (!header)
+            return 0;
+        header->sizeClass = LARGE_CLASS;
+        ++classCache.allocs;
+        return header + 1;
+    }
+
+    if (!classCache.head && !refill(classCache, sizeClass))
+        return 0;
+
+    FreeBlock *block = classCache.head;
+    classCache.head = block->next;
+    --classCache.count;
+    ++classCache.allocs;
+    memset(block, 0, getObjectSize(sizeClass));
+    return block;
+}
+
+extern "C" void __CrackFree(void *object) {
+    if (allocProfiling)
+        recordFree(object);
+
+    if (allocatorType == libcAllocator) {
+        free(object);
+        return;
+    }
+
+    if (!object)
+        return;
+
+    BlockHeader *header = static_cast<BlockHeader *>(object) - 1;
+    unsigned sizeClass = header->sizeClass;
+    assert(sizeClass < CLASS_COUNT && "Freeing a corrupt object");
+
+    // If we can't get a thread cache, leak the object.
+    ThreadCache *cache = getThreadCache();
+    if (!cache)
+        return;
+
+    ClassCache &classCache = cache->classes[sizeClass];
+    ++classCache.frees;
+    if (sizeClass == LARGE_CLASS) {
+        free(header);
+        return;
+    }
+
+    FreeBlock *block = static_cast<FreeBlock *>(object);
+    block->next = classCache.head;
+    classCache.head = block;
+    if (++classCache.count > 2 * BATCH_SIZE) {
+        pthread_mutex_lock(&centralLock);
+        flush(classCache, centralLists[sizeClass], BATCH_SIZE);
+        pthread_mutex_unlock(&centralLock);
+    }
+}
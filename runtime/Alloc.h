@@ -0,0 +1,51 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Object allocator.
+
+#ifndef _runtime_Alloc_h_
+#define _runtime_Alloc_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace crack { namespace runtime {
+
+// Allocator implementations.  The allocator is chosen when the runtime is
+// loaded from the value of the CRACK_ALLOCATOR environment variable
+// ("libc" or "sizeclass", the default).
+enum AllocatorType {
+    libcAllocator = 0,
+    sizeClassAllocator = 1
+};
+
+// Returns the allocator type in use.
+int getAllocatorType();
+
+// Returns the number of size classes (including the final "large object"
+// class, which is used for everything that doesn't fit in the others).
+unsigned getAllocClassCount();
+
+// Returns the maximum object size of the size class.
+size_t getAllocClassSize(unsigned sizeClass);
+
+// Returns the number of allocations and frees for the size class.  These are
+// not synchronized with other threads, so the values are approximate while
+// other threads are allocating.
+uint64_t getAllocCount(unsigned sizeClass);
+uint64_t getFreeCount(unsigned sizeClass);
+
+}} // namespace crack::runtime
+
+// Allocates a zero-filled object of the specified size.  The compiler calls
+// this for all instances of classes derived from Object.
+extern "C" void *__CrackAlloc(size_t size);
+
+// Frees an object allocated with __CrackAlloc().  Called from
+// Object.oper release().
+extern "C" void __CrackFree(void *object);
+
+#endif
@@ -0,0 +1,282 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Per-class allocation profiler.
+//
+// When code is compiled with the "allocProfile" builder option, allocations
+// of Object instances go through __CrackProfAlloc(), which keeps allocation
+// counts and byte counts for each class and a record of every live object.
+// One in every N allocations of a class (N comes from the
+// CRACK_ALLOC_PROFILE_SAMPLE environment variable and defaults to 100) also
+// records the call stack, which we resolve through the debug function table
+// when the report is generated.
+//
+// The report can be obtained from crack.runtime.dumpAllocProfile() or by
+// sending the process SIGUSR2, in which case it is written to standard error
+// on the next profiled allocation.
+
+#include "AllocProfiler.h"
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "debug/DebugTools.h"
+#include "Alloc.h"
+
+using namespace std;
+
+namespace crack { namespace runtime {
+std::atomic<bool> allocProfiling(false);
+}}
+
+using namespace crack::runtime;
+
+namespace {
+
+    // Maximum number of stack frames recorded for a sample.
+    const int MAX_FRAMES = 8;
+
+    // Number of stacks reported for each class.
+    const size_t MAX_STACKS = 5;
+
+    typedef vector<void *> StackTrace;
+    typedef map<StackTrace, uint64_t> StackCountMap;
+
+    struct ClassProfile {
+        string name;
+        uint64_t allocs, frees, liveBytes, totalBytes;
+        StackCountMap stacks;
+
+        ClassProfile(const string &name) :
+            name(name),
+            allocs(0),
+            frees(0),
+            liveBytes(0),
+            totalBytes(0) {
+        }
+    };
+
+    struct Allocation {
+        ClassProfile *profile;
+        size_t size;
+    };
+
+    // Class profiles by class name.
+    typedef map<string, ClassProfile *> ClassProfileMap;
+
+    // Class profiles by the address of the name constant.  Every module has
+    // its own copy of the name, so there may be several entries for a
+    // class.
+    typedef map<const char *, ClassProfile *> NameCacheMap;
+
+    typedef map<void *, Allocation> AllocationMap;
+
+    pthread_mutex_t profileLock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_once_t profilerOnce = PTHREAD_ONCE_INIT;
+    ClassProfileMap classProfiles;
+    NameCacheMap nameCache;
+    AllocationMap liveObjects;
+    unsigned sampleRate = 100;
+    volatile sig_atomic_t dumpRequested = 0;
+
+    void requestDump(int signal) {
+        dumpRequested = 1;
+    }
+
+    void initProfiler() {
+        if (const char *rate = getenv("CRACK_ALLOC_PROFILE_SAMPLE"))
+            sampleRate = atoi(rate);
+
+        // Don't take over SIGUSR2 if the program is using it.
+        struct sigaction action;
+        if (!sigaction(SIGUSR2, 0, &action) &&
+            action.sa_handler == SIG_DFL
+            ) {
+            action.sa_handler = requestDump;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            sigaction(SIGUSR2, &action, 0);
+        }
+
+        allocProfiling = true;
+    }
+
+    // Returns the profile for the class.  Caller must hold the profile lock.
+    ClassProfile *getClassProfile(const char *className) {
+        NameCacheMap::iterator iter = nameCache.find(className);
+        if (iter != nameCache.end())
+            return iter->second;
+
+        ClassProfile *&profile = classProfiles[className];
+        if (!profile)
+            profile = new ClassProfile(className);
+        nameCache[className] = profile;
+        return profile;
+    }
+
+    bool compareLiveBytes(const ClassProfile *a, const ClassProfile *b) {
+        return a->liveBytes > b->liveBytes ||
+               (a->liveBytes == b->liveBytes &&
+                a->totalBytes > b->totalBytes
+                );
+    }
+
+    bool compareCounts(const StackCountMap::value_type *a,
+                       const StackCountMap::value_type *b
+                       ) {
+        return a->second > b->second;
+    }
+
+    void writeFrame(ostream &out, void *address) {
+        const char *info[3];
+        crack::debug::getLocation(address, info);
+        if (info[0]) {
+            out << "        " << info[0];
+            if (info[1])
+                out << " (" << info[1] << ":" <<
+                    static_cast<int>(reinterpret_cast<intptr_t>(info[2])) <<
+                    ")";
+            out << "\n";
+        } else {
+            out << "        " << address << "\n";
+        }
+    }
+
+    void writeStacks(ostream &out, const ClassProfile *profile) {
+        vector<const StackCountMap::value_type *> stacks;
+        for (StackCountMap::const_iterator iter = profile->stacks.begin();
+             iter != profile->stacks.end();
+             ++iter
+             )
+            stacks.push_back(&*iter);
+        sort(stacks.begin(), stacks.end(), compareCounts);
+
+        out << "\nAllocation stacks for " << profile->name << ":\n";
+        for (size_t i = 0; i < stacks.size() && i < MAX_STACKS; ++i) {
+            out << "    " << stacks[i]->second << " samples:\n";
+            const StackTrace &trace = stacks[i]->first;
+            for (StackTrace::const_iterator frame = trace.begin();
+                 frame != trace.end();
+                 ++frame
+                 )
+                writeFrame(out, *frame);
+        }
+    }
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+void recordFree(void *object) {
+    pthread_mutex_lock(&profileLock);
+    AllocationMap::iterator iter = liveObjects.find(object);
+    if (iter != liveObjects.end()) {
+        ClassProfile *profile = iter->second.profile;
+        ++profile->frees;
+        profile->liveBytes -= iter->second.size;
+        liveObjects.erase(iter);
+    }
+    pthread_mutex_unlock(&profileLock);
+}
+
+void dumpAllocProfile(int fd) {
+    ostringstream out;
+    if (!allocProfiling) {
+        out << "Allocation profiling is not enabled (use -b allocProfile)\n";
+    } else {
+        pthread_mutex_lock(&profileLock);
+        vector<const ClassProfile *> profiles;
+        for (ClassProfileMap::const_iterator iter = classProfiles.begin();
+             iter != classProfiles.end();
+             ++iter
+             )
+            profiles.push_back(iter->second);
+        sort(profiles.begin(), profiles.end(), compareLiveBytes);
+
+        out << "Allocation profile (" << liveObjects.size() <<
+            " live objects, stacks sampled 1 in " << sampleRate <<
+            " allocations)\n" <<
+            setw(12) << "allocs" << setw(12) << "live" <<
+            setw(16) << "live bytes" << setw(16) << "total bytes" <<
+            "  class\n";
+        for (size_t i = 0; i < profiles.size(); ++i) {
+            const ClassProfile *profile = profiles[i];
+            out << setw(12) << profile->allocs <<
+                setw(12) << profile->allocs - profile->frees <<
+                setw(16) << profile->liveBytes <<
+                setw(16) << profile->totalBytes << "  " <<
+                profile->name << "\n";
+        }
+
+        for (size_t i = 0; i < profiles.size(); ++i)
+            if (!profiles[i]->stacks.empty())
+                writeStacks(out, profiles[i]);
+        pthread_mutex_unlock(&profileLock);
+    }
+
+    string report = out.str();
+    const char *data = report.data();
+    size_t remaining = report.size();
+    while (remaining) {
+        ssize_t rc = write(fd, data, remaining);
+        if (rc <= 0)
+            break;
+        data += rc;
+        remaining -= rc;
+    }
+}
+
+}} // namespace crack::runtime
+
+extern "C" void *__CrackProfAlloc(size_t size, const char *className) {
+    pthread_once(&profilerOnce, initProfiler);
+
+    if (dumpRequested) {
+        dumpRequested = 0;
+        dumpAllocProfile(2);
+    }
+
+    void *object = __CrackAlloc(size);
+    if (!object)
+        return 0;
+
+    pthread_mutex_lock(&profileLock);
+    ClassProfile *profile = getClassProfile(className);
+    bool sample = sampleRate && profile->allocs % sampleRate == 0;
+    ++profile->allocs;
+    profile->liveBytes += size;
+    profile->totalBytes += size;
+    Allocation &allocation = liveObjects[object];
+    allocation.profile = profile;
+    allocation.size = size;
+    pthread_mutex_unlock(&profileLock);
+
+    // backtrace() is too slow to call with the lock held.
+    if (sample) {
+        void *frames[MAX_FRAMES + 1];
+        int frameCount = backtrace(frames, MAX_FRAMES + 1);
+
+        // Skip our own frame.
+        if (frameCount > 1) {
+            StackTrace trace(frames + 1, frames + frameCount);
+            pthread_mutex_lock(&profileLock);
+            ++profile->stacks[trace];
+            pthread_mutex_unlock(&profileLock);
+        }
+    }
+
+    return object;
+}
@@ -0,0 +1,37 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Per-class allocation profiler.
+
+#ifndef _runtime_AllocProfiler_h_
+#define _runtime_AllocProfiler_h_
+
+#include <stddef.h>
+#include <atomic>
+
+namespace crack { namespace runtime {
+
+// True once the first profiled allocation has been made.  __CrackFree()
+// only needs to call recordFree() if this is set.  It is set by whichever
+// thread makes the first profiled allocation and read on every free.
+extern std::atomic<bool> allocProfiling;
+
+// Record that an object has been freed.  Objects that weren't allocated by
+// __CrackProfAlloc() are ignored.
+void recordFree(void *object);
+
+// Write a report of allocation counts, live objects, live bytes and sampled
+// allocation stacks for every class to the file descriptor.
+void dumpAllocProfile(int fd);
+
+}} // namespace crack::runtime
+
+// Allocates an object through __CrackAlloc() and records it in the profile
+// for 'className'.  The compiler emits calls to this instead of
+// __CrackAlloc() when the "allocProfile" builder option is specified.
+extern "C" void *__CrackProfAlloc(size_t size, const char *className);
+
+#endif
@@ -0,0 +1,59 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Atomic operations on pointer sized integers and a mutex for code that
+// can't depend on crack.threads.
+
+#include "Atomic.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+namespace crack { namespace runtime {
+
+intptr_t atomicLoad(intptr_t *addr) {
+    return __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+}
+
+void atomicStore(intptr_t *addr, intptr_t val) {
+    __atomic_store_n(addr, val, __ATOMIC_SEQ_CST);
+}
+
+intptr_t atomicAdd(intptr_t *addr, intptr_t delta) {
+    return __atomic_add_fetch(addr, delta, __ATOMIC_SEQ_CST);
+}
+
+bool atomicCompareAndSwap(intptr_t *addr, intptr_t expected, intptr_t val) {
+    return __atomic_compare_exchange_n(addr, &expected, val, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST
+                                       );
+}
+
+void *mutexNew() {
+    pthread_mutex_t *mutex =
+        (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mutex, 0);
+    return mutex;
+}
+
+void mutexFree(void *mutex) {
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+void mutexLock(void *mutex) {
+    pthread_mutex_lock((pthread_mutex_t *)mutex);
+}
+
+bool mutexTryLock(void *mutex) {
+    return !pthread_mutex_trylock((pthread_mutex_t *)mutex);
+}
+
+void mutexUnlock(void *mutex) {
+    pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+}} // namespace crack::runtime
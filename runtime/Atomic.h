@@ -0,0 +1,48 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Atomic operations on pointer sized integers and a mutex for code that
+// can't depend on crack.threads.
+
+#ifndef _runtime_Atomic_h_
+#define _runtime_Atomic_h_
+
+#include <stdint.h>
+
+namespace crack { namespace runtime {
+
+// All of these are sequentially consistent.  The compiler only provides
+// atomic add, subtract and load for atomic_int variables, these give crack
+// code compare-and-swap and operations on integers stored in arrays.
+
+// Returns the value at 'addr'.
+intptr_t atomicLoad(intptr_t *addr);
+
+// Stores 'val' at 'addr'.
+void atomicStore(intptr_t *addr, intptr_t val);
+
+// Adds 'delta' to the value at 'addr', returns the new value.
+intptr_t atomicAdd(intptr_t *addr, intptr_t delta);
+
+// Stores 'val' at 'addr' if the value at 'addr' is equal to 'expected'.
+// Returns true if the value was stored.
+bool atomicCompareAndSwap(intptr_t *addr, intptr_t expected, intptr_t val);
+
+// Creates a (non-recursive) mutex, release it with mutexFree().
+void *mutexNew();
+
+void mutexFree(void *mutex);
+
+void mutexLock(void *mutex);
+
+// Locks the mutex if it's free, returns true if it was locked.
+bool mutexTryLock(void *mutex);
+
+void mutexUnlock(void *mutex);
+
+}} // namespace crack::runtime
+
+#endif
@@ -0,0 +1,329 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Vectorized searching and scanning of byte buffers.
+//
+// Single byte and substring searches use memchr(), memrchr() and memmem(),
+// which the C library already implements with SIMD.  The rest are written
+// with GCC vector extensions over 32 byte vectors like the kernels in
+// Numeric.cc, with an AVX2 clone on x86.
+
+#include "BufferSearch.h"
+
+#include <stdint.h>
+#include <string.h>
+#include "ext/Func.h"
+#include "ext/Module.h"
+#include "ext/Type.h"
+
+using namespace crack::ext;
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    (defined(__x86_64__) || defined(__i386__))
+#   define KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#   define KERNEL
+#endif
+
+#define INLINE inline __attribute__((always_inline))
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace {
+
+typedef uint8_t V __attribute__((vector_size(32)));
+typedef uint64_t L __attribute__((vector_size(32)));
+const size_t W = sizeof(V);
+
+// The largest byte set that findAnyByte() compares against directly,
+// larger sets are looked up in a table one byte at a time.
+const unsigned int MAX_VECTOR_SET = 8;
+
+INLINE V load(const char *p) {
+    V v;
+    memcpy(&v, p, W);
+    return v;
+}
+
+INLINE void store(char *p, const V &v) {
+    memcpy(p, &v, W);
+}
+
+INLINE V splat(uint8_t c) {
+    V v;
+    for (size_t i = 0; i < W; ++i)
+        v[i] = c;
+    return v;
+}
+
+// Comparisons produce 0xff in the bytes where they are true.  Converts that
+// to a V.
+#define MASK(expr) ((V)(expr))
+
+INLINE bool any(const V &mask) {
+    L l = (L)mask;
+    return l[0] | l[1] | l[2] | l[3];
+}
+
+// Returns the index of the first set byte of a mask that has one.
+INLINE int first(const V &mask) {
+    L l = (L)mask;
+    for (int i = 0; ; ++i) {
+        if (l[i])
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            return i * 8 + __builtin_clzll(l[i]) / 8;
+#else
+            return i * 8 + __builtin_ctzll(l[i]) / 8;
+#endif
+    }
+}
+
+// Returns a mask of the bytes of 'v' that are in 'set'.
+INLINE V inSet(const V &v, const V *set, unsigned int setSize) {
+    V mask = MASK(v == set[0]);
+    for (unsigned int i = 1; i < setSize; ++i)
+        mask |= MASK(v == set[i]);
+    return mask;
+}
+
+// Finds the first byte of 'buf' that is in 'set' (or not in it if
+// 'negate' is true).
+INLINE int findInSet(const char *buf, unsigned int size, const char *set,
+                     unsigned int setSize,
+                     bool negate
+                     ) {
+    size_t i = 0;
+    if (setSize && setSize <= MAX_VECTOR_SET) {
+        V needles[MAX_VECTOR_SET];
+        for (unsigned int j = 0; j < setSize; ++j)
+            needles[j] = splat(set[j]);
+        V flip = splat(negate ? 0xff : 0);
+        for (; i + W <= size; i += W) {
+            V mask = inSet(load(buf + i), needles, setSize) ^ flip;
+            if (any(mask))
+                return i + first(mask);
+        }
+    }
+
+    bool table[256] = {false};
+    for (unsigned int j = 0; j < setSize; ++j)
+        table[(uint8_t)set[j]] = true;
+    for (; i < size; ++i)
+        if (table[(uint8_t)buf[i]] != negate)
+            return i;
+    return -1;
+}
+
+INLINE void changeCase(char *dst, const char *src, unsigned int size,
+                       uint8_t lower,
+                       uint8_t upper
+                       ) {
+    V lo = splat(lower), hi = splat(upper), bit = splat(0x20);
+    size_t i = 0;
+    for (; i + W <= size; i += W) {
+        V v = load(src + i);
+        V mask = MASK(v >= lo) & MASK(v <= hi);
+        store(dst + i, v ^ (mask & bit));
+    }
+    for (; i < size; ++i) {
+        uint8_t c = src[i];
+        dst[i] = c >= lower && c <= upper ? c ^ 0x20 : c;
+    }
+}
+
+// Returns the length of the valid UTF-8 sequence starting at 'p', or 0 if
+// it is invalid or truncated.
+INLINE size_t utf8Sequence(const uint8_t *p, size_t avail) {
+    uint8_t c = p[0];
+    if (c < 0x80)
+        return 1;
+
+    size_t len;
+    uint8_t min = 0x80, max = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        len = 2;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        len = 3;
+        if (c == 0xe0)
+            min = 0xa0;     // overlong
+        else if (c == 0xed)
+            max = 0x9f;     // surrogates
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        len = 4;
+        if (c == 0xf0)
+            min = 0x90;     // overlong
+        else if (c == 0xf4)
+            max = 0x8f;     // beyond U+10FFFF
+    } else {
+        return 0;
+    }
+
+    if (avail < len || p[1] < min || p[1] > max)
+        return 0;
+    for (size_t i = 2; i < len; ++i)
+        if ((p[i] & 0xc0) != 0x80)
+            return 0;
+    return len;
+}
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+int findByte(const char *buf, unsigned int size, char c) {
+    const void *p = memchr(buf, c, size);
+    return p ? (const char *)p - buf : -1;
+}
+
+int rfindByte(const char *buf, unsigned int size, char c) {
+    const void *p = memrchr(buf, c, size);
+    return p ? (const char *)p - buf : -1;
+}
+
+int findBytes(const char *buf, unsigned int size, const char *sub,
+              unsigned int subSize
+              ) {
+    const void *p = memmem(buf, size, sub, subSize);
+    return p ? (const char *)p - buf : -1;
+}
+
+int rfindBytes(const char *buf, unsigned int size, const char *sub,
+               unsigned int subSize
+               ) {
+    if (subSize > size)
+        return -1;
+    if (!subSize)
+        return size;
+
+    // look for the first byte with memrchr() in the part of the buffer
+    // where the substring could start.
+    size_t end = size - subSize + 1;
+    while (end) {
+        const char *p = (const char *)memrchr(buf, sub[0], end);
+        if (!p)
+            return -1;
+        if (!memcmp(p + 1, sub + 1, subSize - 1))
+            return p - buf;
+        end = p - buf;
+    }
+    return -1;
+}
+
+KERNEL int findAnyByte(const char *buf, unsigned int size, const char *set,
+                       unsigned int setSize
+                       ) {
+    return findInSet(buf, size, set, setSize, false);
+}
+
+KERNEL int findNotAnyByte(const char *buf, unsigned int size,
+                          const char *set,
+                          unsigned int setSize
+                          ) {
+    return findInSet(buf, size, set, setSize, true);
+}
+
+KERNEL unsigned int countByte(const char *buf, unsigned int size, char c) {
+    V needle = splat(c);
+    unsigned int total = 0;
+    size_t i = 0;
+    while (i + W <= size) {
+        // count in byte lanes, emptying them before they can overflow.
+        V counts = splat(0);
+        for (int n = 0; n < 255 && i + W <= size; ++n, i += W)
+            counts -= MASK(load(buf + i) == needle);
+        L l = (L)counts;
+        for (int j = 0; j < 4; ++j) {
+            uint64_t x = l[j];
+            x = (x & 0x00ff00ff00ff00ffULL) + (x >> 8 & 0x00ff00ff00ff00ffULL);
+            total += x * 0x0001000100010001ULL >> 48;
+        }
+    }
+    for (; i < size; ++i)
+        total += buf[i] == c;
+    return total;
+}
+
+KERNEL void asciiToLower(char *dst, const char *src, unsigned int size) {
+    changeCase(dst, src, size, 'A', 'Z');
+}
+
+KERNEL void asciiToUpper(char *dst, const char *src, unsigned int size) {
+    changeCase(dst, src, size, 'a', 'z');
+}
+
+KERNEL int findInvalidUtf8(const char *buf, unsigned int size) {
+    const uint8_t *p = (const uint8_t *)buf;
+    V high = splat(0x80);
+    size_t i = 0;
+    while (i < size) {
+        // skip blocks of ASCII, then check sequences one at a time to the
+        // end of the block.
+        if (i + W <= size && !any(load(buf + i) & high)) {
+            i += W;
+            continue;
+        }
+        size_t blockEnd = i + W < size ? i + W : size;
+        while (i < blockEnd) {
+            size_t len = utf8Sequence(p + i, size - i);
+            if (!len)
+                return i;
+            i += len;
+        }
+    }
+    return -1;
+}
+
+void addBufferSearch(Module *mod) {
+    Type *intType = mod->getIntType();
+    Type *uintType = mod->getUintType();
+    Type *byteType = mod->getByteType();
+    Type *byteptrType = mod->getByteptrType();
+    Type *voidType = mod->getVoidType();
+
+    Func *f = mod->addFunc(intType, "findByte", (void *)findByte);
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+    f->addArg(byteType, "c");
+
+    f = mod->addFunc(intType, "rfindByte", (void *)rfindByte);
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+    f->addArg(byteType, "c");
+
+    f = mod->addFunc(uintType, "countByte", (void *)countByte);
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+    f->addArg(byteType, "c");
+
+    struct { const char *name; void *func; } pairFuncs[] = {
+        {"findBytes", (void *)findBytes},
+        {"rfindBytes", (void *)rfindBytes},
+        {"findAnyByte", (void *)findAnyByte},
+        {"findNotAnyByte", (void *)findNotAnyByte}
+    };
+    for (int i = 0; i < 4; ++i) {
+        f = mod->addFunc(intType, pairFuncs[i].name, pairFuncs[i].func);
+        f->addArg(byteptrType, "buf");
+        f->addArg(uintType, "size");
+        f->addArg(byteptrType, "other");
+        f->addArg(uintType, "otherSize");
+    }
+
+    f = mod->addFunc(voidType, "asciiToLower", (void *)asciiToLower);
+    f->addArg(byteptrType, "dst");
+    f->addArg(byteptrType, "src");
+    f->addArg(uintType, "size");
+
+    f = mod->addFunc(voidType, "asciiToUpper", (void *)asciiToUpper);
+    f->addArg(byteptrType, "dst");
+    f->addArg(byteptrType, "src");
+    f->addArg(uintType, "size");
+
+    f = mod->addFunc(intType, "findInvalidUtf8", (void *)findInvalidUtf8);
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+}
+
+}} // namespace crack::runtime
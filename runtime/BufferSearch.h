@@ -0,0 +1,62 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Vectorized searching and scanning of byte buffers.
+
+#ifndef _runtime_BufferSearch_h_
+#define _runtime_BufferSearch_h_
+
+namespace crack { namespace ext {
+    class Module;
+}}
+
+namespace crack { namespace runtime {
+
+// The search functions return the index of the first (or last, for the
+// rfind*() functions) match in the 'size' bytes at 'buf', or -1 if there is
+// none.
+
+int findByte(const char *buf, unsigned int size, char c);
+int rfindByte(const char *buf, unsigned int size, char c);
+
+// An empty 'sub' matches at 0 for findBytes() and at 'size' for
+// rfindBytes().
+int findBytes(const char *buf, unsigned int size, const char *sub,
+              unsigned int subSize
+              );
+int rfindBytes(const char *buf, unsigned int size, const char *sub,
+               unsigned int subSize
+               );
+
+// Finds the first byte that is (or isn't) one of the 'setSize' bytes at
+// 'set'.
+int findAnyByte(const char *buf, unsigned int size, const char *set,
+                unsigned int setSize
+                );
+int findNotAnyByte(const char *buf, unsigned int size, const char *set,
+                   unsigned int setSize
+                   );
+
+// Returns the number of occurrences of 'c'.
+unsigned int countByte(const char *buf, unsigned int size, char c);
+
+// Copies 'size' bytes from 'src' to 'dst' converting ASCII letters to
+// lower or upper case.  Other bytes are copied unchanged.  'dst' may be the
+// same as 'src'.
+void asciiToLower(char *dst, const char *src, unsigned int size);
+void asciiToUpper(char *dst, const char *src, unsigned int size);
+
+// Returns the index of the first byte of the first invalid UTF-8 sequence
+// (including overlong forms, surrogates and truncated sequences), or -1 if
+// the buffer is valid UTF-8.
+int findInvalidUtf8(const char *buf, unsigned int size);
+
+// Adds the functions above to 'mod'.
+void addBufferSearch(crack::ext::Module *mod);
+
+}} // namespace crack::runtime
+
+#endif
@@ -0,0 +1,139 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Candidate root buffer for the cycle collector.
+//
+// The buffer is a set of object addresses.  It is implemented in C++ (rather
+// than in crack.cycles) so that adding and removing candidates doesn't
+// allocate or release any crack objects, which would recursively add more
+// candidates.  We use an open addressing hash table because the buffer gets
+// updated on every release of a tracked object.
+
+#include "Cycles.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+    // Slot markers.  Neither of these can be the address of an object.
+    void *const EMPTY = 0;
+    void *const DELETED = reinterpret_cast<void *>(1);
+
+    const size_t INITIAL_CAPACITY = 1024;
+
+    pthread_mutex_t candidateLock = PTHREAD_MUTEX_INITIALIZER;
+    void **slots;
+    size_t capacity, count, used;
+
+    // Where popCycleCandidate() starts looking for an occupied slot.
+    size_t popCursor;
+
+    inline size_t getSlot(void *object) {
+        uintptr_t val = reinterpret_cast<uintptr_t>(object) >> 4;
+        return (val * 2654435761U) & (capacity - 1);
+    }
+
+    void insert(void *object);
+
+    void resize(size_t newCapacity) {
+        void **oldSlots = slots;
+        size_t oldCapacity = capacity;
+        slots = static_cast<void **>(calloc(newCapacity, sizeof(void *)));
+        capacity = newCapacity;
+        count = used = popCursor = 0;
+        for (size_t i = 0; i < oldCapacity; ++i)
+            if (oldSlots[i] != EMPTY && oldSlots[i] != DELETED)
+                insert(oldSlots[i]);
+        free(oldSlots);
+    }
+
+    void insert(void *object) {
+        // keep the load factor (including deleted slots) under 1/2.
+        if ((used + 1) * 2 > capacity)
+            resize(count * 4 > capacity ? capacity * 2 :
+                    (capacity ? capacity : INITIAL_CAPACITY)
+                   );
+
+        size_t i = getSlot(object);
+        size_t firstDeleted = capacity;
+        while (slots[i] != EMPTY) {
+            if (slots[i] == object)
+                return;
+            else if (slots[i] == DELETED && firstDeleted == capacity)
+                firstDeleted = i;
+            i = (i + 1) & (capacity - 1);
+        }
+
+        if (firstDeleted != capacity) {
+            slots[firstDeleted] = object;
+        } else {
+            slots[i] = object;
+            ++used;
+        }
+        ++count;
+    }
+
+    void remove(void *object) {
+        if (!count)
+            return;
+
+        size_t i = getSlot(object);
+        while (slots[i] != EMPTY) {
+            if (slots[i] == object) {
+                slots[i] = DELETED;
+                --count;
+                return;
+            }
+            i = (i + 1) & (capacity - 1);
+        }
+    }
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+void *popCycleCandidate() {
+    void *result = 0;
+    pthread_mutex_lock(&candidateLock);
+    if (count) {
+        while (slots[popCursor] == EMPTY || slots[popCursor] == DELETED)
+            popCursor = (popCursor + 1) & (capacity - 1);
+        result = slots[popCursor];
+        slots[popCursor] = DELETED;
+        --count;
+    }
+    pthread_mutex_unlock(&candidateLock);
+    return result;
+}
+
+unsigned getCycleCandidateCount() {
+    return count;
+}
+
+void clearCycleCandidates() {
+    pthread_mutex_lock(&candidateLock);
+    if (slots)
+        memset(slots, 0, capacity * sizeof(void *));
+    count = used = popCursor = 0;
+    pthread_mutex_unlock(&candidateLock);
+}
+
+}} // namespace crack::runtime
+
+extern "C" void __CrackAddCycleCandidate(void *object) {
+    pthread_mutex_lock(&candidateLock);
+    insert(object);
+    pthread_mutex_unlock(&candidateLock);
+}
+
+extern "C" void __CrackRemoveCycleCandidate(void *object) {
+    pthread_mutex_lock(&candidateLock);
+    remove(object);
+    pthread_mutex_unlock(&candidateLock);
+}
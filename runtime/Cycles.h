@@ -0,0 +1,35 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Candidate root buffer for the cycle collector.
+
+#ifndef _runtime_Cycles_h_
+#define _runtime_Cycles_h_
+
+namespace crack { namespace runtime {
+
+// Removes an arbitrary object from the candidate buffer and returns it.
+// Returns null if the buffer is empty.
+void *popCycleCandidate();
+
+// Returns the number of objects in the candidate buffer.
+unsigned getCycleCandidateCount();
+
+// Removes all objects from the candidate buffer.
+void clearCycleCandidates();
+
+}} // namespace crack::runtime
+
+// Add an object to the candidate buffer.  Object.oper release() calls this
+// when cycle collection is enabled and the reference count of the object is
+// decremented to a non-zero value.  Objects are not bound by the buffer.
+extern "C" void __CrackAddCycleCandidate(void *object);
+
+// Remove an object from the candidate buffer, called before the object is
+// freed.
+extern "C" void __CrackRemoveCycleCandidate(void *object);
+
+#endif
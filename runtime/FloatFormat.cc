@@ -0,0 +1,964 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Locale independent conversion of floating point numbers to and from text.
+//
+// Shortest round-trip formatting uses the Ryu algorithm (Ulf Adams, "Ryu:
+// Fast Float-to-String Conversion", PLDI 2018).  The fixed precision
+// formats expand the exact decimal value of the number with big integer
+// arithmetic and round that.  Parsing uses the Clinger fast path and the
+// Eisel-Lemire algorithm (Daniel Lemire, "Number Parsing at a Gigabyte per
+// Second", 2021), falling back to strtod() for the rare inputs that they
+// can't decide.  None of these allocate memory except the fallback for
+// numbers longer than 1KB.
+
+#include "FloatFormat.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ext/Func.h"
+#include "ext/Module.h"
+#include "ext/Type.h"
+#include "FloatTables.h"
+
+using namespace crack::ext;
+using namespace crack::runtime::floattables;
+
+namespace {
+
+// 64 x 64 -> 128 bit multiplication.
+inline uint64_t umul128(uint64_t a, uint64_t b, uint64_t *high) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 p = (unsigned __int128)a * b;
+    *high = (uint64_t)(p >> 64);
+    return (uint64_t)p;
+#else
+    uint64_t aLo = (uint32_t)a, aHi = a >> 32,
+             bLo = (uint32_t)b, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)ll;
+#endif
+}
+
+inline int leadingZeros64(uint64_t v) {
+    return __builtin_clzll(v);
+}
+
+// Output with snprintf() style truncation.
+struct Out {
+    char *buf;
+    unsigned int size, pos;
+
+    Out(char *buf, unsigned int size) : buf(buf), size(size), pos(0) {}
+
+    void put(char c) {
+        if (pos < size)
+            buf[pos] = c;
+        ++pos;
+    }
+
+    void put(const char *s, unsigned int len) {
+        for (unsigned int i = 0; i < len; ++i)
+            put(s[i]);
+    }
+
+    void putZeros(int count) {
+        for (int i = 0; i < count; ++i)
+            put('0');
+    }
+
+    // Writes the exponent of scientific notation, at least two digits.
+    void putExponent(int exp) {
+        put('e');
+        put(exp < 0 ? '-' : '+');
+        if (exp < 0)
+            exp = -exp;
+        if (exp >= 100)
+            put('0' + exp / 100);
+        put('0' + exp / 10 % 10);
+        put('0' + exp % 10);
+    }
+};
+
+// Writes "nan" or "inf" for non-finite values.  Returns true if it did.
+bool putSpecial(Out &out, bool negative, bool isNan) {
+    if (negative)
+        out.put('-');
+    out.put(isNan ? "nan" : "inf", 3);
+    return true;
+}
+
+// ---- Shortest round trip (Ryu) ----
+
+const int POW5_INV_BITCOUNT = 125, POW5_BITCOUNT = 125;
+
+// Bit length of 5^e, for 0 <= e <= 3528.
+inline int pow5bits(int e) {
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)) for 0 <= e <= 1650.
+inline uint32_t log10Pow2(int e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)) for 0 <= e <= 2620.
+inline uint32_t log10Pow5(int e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+inline bool multipleOfPowerOf5(uint64_t value, uint32_t p) {
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        ++count;
+    }
+    return count >= p;
+}
+
+inline bool multipleOfPowerOf2(uint64_t value, uint32_t p) {
+    return (value & ((1ull << p) - 1)) == 0;
+}
+
+// Returns (m * mul) >> j where mul is a 128 bit table entry and j >= 64.
+inline uint64_t mulShift(uint64_t m, const uint64_t *mul, int j) {
+    uint64_t high1, high0;
+    uint64_t low1 = umul128(m, mul[1], &high1);
+    umul128(m, mul[0], &high0);
+    uint64_t sum = high0 + low1;
+    if (sum < high0)
+        ++high1;
+    int shift = j - 64;
+    return shift ? (high1 << (64 - shift)) | (sum >> shift) : sum;
+}
+
+struct Decimal {
+    uint64_t digits;
+    int exponent;
+};
+
+// The core of Ryu: finds the shortest decimal in the rounding interval of
+// the binary floating point number m2 * 2^e2.  'mmShift' is false if the
+// interval below is half the size of the one above, which is the case for
+// the powers of two other than the smallest normal number.  This works for
+// both floats and doubles because float is a subset of double.
+Decimal shortestDecimal(uint64_t m2, int e2, bool mmShift) {
+    e2 -= 2;
+    bool acceptBounds = (m2 & 1) == 0;
+    uint64_t mv = 4 * m2;
+    uint64_t vr, vp, vm;
+    int e10;
+    bool vmIsTrailingZeros = false, vrIsTrailingZeros = false;
+
+    if (e2 >= 0) {
+        uint32_t q = log10Pow2(e2) - (e2 > 3);
+        e10 = (int)q;
+        int k = POW5_INV_BITCOUNT + pow5bits(q) - 1;
+        int i = -e2 + (int)q + k;
+        vr = mulShift(4 * m2, POW5_INV_SPLIT[q], i);
+        vp = mulShift(4 * m2 + 2, POW5_INV_SPLIT[q], i);
+        vm = mulShift(4 * m2 - 1 - mmShift, POW5_INV_SPLIT[q], i);
+        if (q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5, if any.
+            if (mv % 5 == 0)
+                vrIsTrailingZeros = multipleOfPowerOf5(mv, q);
+            else if (acceptBounds)
+                vmIsTrailingZeros =
+                    multipleOfPowerOf5(mv - 1 - mmShift, q);
+            else
+                vp -= multipleOfPowerOf5(mv + 2, q);
+        }
+    } else {
+        uint32_t q = log10Pow5(-e2) - (-e2 > 1);
+        e10 = (int)q + e2;
+        int i = -e2 - (int)q;
+        int k = pow5bits(i) - POW5_BITCOUNT;
+        int j = (int)q - k;
+        vr = mulShift(4 * m2, POW5_SPLIT[i], j);
+        vp = mulShift(4 * m2 + 2, POW5_SPLIT[i], j);
+        vm = mulShift(4 * m2 - 1 - mmShift, POW5_SPLIT[i], j);
+        if (q <= 1) {
+            // mv has at least two trailing zero bits, so vr is a multiple of
+            // 10 and the bounds decide the rest.
+            vrIsTrailingZeros = true;
+            if (acceptBounds)
+                vmIsTrailingZeros = mmShift;
+            else
+                --vp;
+        } else if (q < 63) {
+            vrIsTrailingZeros = multipleOfPowerOf2(mv, q);
+        }
+    }
+
+    // Remove digits while the interval still contains a shorter number.
+    int removed = 0;
+    uint32_t lastRemovedDigit = 0;
+    uint64_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        // The general case, only needed when the exact value or the lower
+        // bound has trailing decimal zeros.
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = (uint32_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+        }
+        // round half to even if the exact value ends in 5 followed by zeros.
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+            lastRemovedDigit = 4;
+        output = vr +
+                 ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) ||
+                  lastRemovedDigit >= 5
+                  );
+    } else {
+        bool roundUp = false;
+        if (vp / 100 > vm / 100) {
+            roundUp = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            roundUp = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        output = vr + (vr == vm || roundUp);
+    }
+
+    Decimal result = {output, e10 + removed};
+    return result;
+}
+
+int decimalLength(uint64_t v) {
+    int len = 1;
+    while (v >= 10) {
+        v /= 10;
+        ++len;
+    }
+    return len;
+}
+
+// Writes the decimal in the format described for formatFloat64().
+int writeShortest(Out &out, bool negative, Decimal dec) {
+    char digits[20];
+    int len = decimalLength(dec.digits);
+    uint64_t v = dec.digits;
+    for (int i = len - 1; i >= 0; --i) {
+        digits[i] = '0' + v % 10;
+        v /= 10;
+    }
+
+    if (negative)
+        out.put('-');
+
+    // the exponent for scientific notation.
+    int exp = dec.exponent + len - 1;
+    if (exp < -4 || exp >= 16) {
+        out.put(digits[0]);
+        if (len > 1) {
+            out.put('.');
+            out.put(digits + 1, len - 1);
+        }
+        out.putExponent(exp);
+    } else if (exp < 0) {
+        out.put("0.", 2);
+        out.putZeros(-exp - 1);
+        out.put(digits, len);
+    } else if (exp + 1 >= len) {
+        out.put(digits, len);
+        out.putZeros(exp + 1 - len);
+        out.put(".0", 2);
+    } else {
+        out.put(digits, exp + 1);
+        out.put('.');
+        out.put(digits + exp + 1, len - exp - 1);
+    }
+    return out.pos;
+}
+
+// ---- Exact decimal expansion ----
+
+// Big enough for 2^1024 and for 2^53 * 5^1074.
+const int BIG_WORDS = 84;
+
+// Enough for the digits of the values above.
+const int MAX_DIGITS = 800;
+
+struct BigInt {
+    uint32_t words[BIG_WORDS];
+    int size;
+
+    explicit BigInt(uint64_t val) : size(0) {
+        while (val) {
+            words[size++] = (uint32_t)val;
+            val >>= 32;
+        }
+    }
+
+    void mulSmall(uint32_t factor) {
+        uint64_t carry = 0;
+        for (int i = 0; i < size; ++i) {
+            uint64_t p = (uint64_t)words[i] * factor + carry;
+            words[i] = (uint32_t)p;
+            carry = p >> 32;
+        }
+        if (carry)
+            words[size++] = (uint32_t)carry;
+    }
+
+    void mulPow5(int exp) {
+        // 5^13 is the largest power of five that fits in 32 bits.
+        while (exp >= 13) {
+            mulSmall(1220703125);
+            exp -= 13;
+        }
+        uint32_t factor = 1;
+        while (exp--)
+            factor *= 5;
+        if (factor > 1)
+            mulSmall(factor);
+    }
+
+    void shiftLeft(int bits) {
+        int wordShift = bits / 32, bitShift = bits % 32;
+        if (bitShift) {
+            words[size] = 0;
+            for (int i = size; i > 0; --i)
+                words[i] = (words[i] << bitShift) |
+                           (words[i - 1] >> (32 - bitShift));
+            words[0] <<= bitShift;
+            if (words[size])
+                ++size;
+        }
+        if (wordShift) {
+            memmove(words + wordShift, words, size * sizeof(uint32_t));
+            memset(words, 0, wordShift * sizeof(uint32_t));
+            size += wordShift;
+        }
+    }
+
+    // Divides by 'divisor' and returns the remainder.
+    uint32_t divSmall(uint32_t divisor) {
+        uint64_t rem = 0;
+        for (int i = size - 1; i >= 0; --i) {
+            uint64_t cur = (rem << 32) | words[i];
+            words[i] = (uint32_t)(cur / divisor);
+            rem = cur % divisor;
+        }
+        while (size && !words[size - 1])
+            --size;
+        return (uint32_t)rem;
+    }
+};
+
+// Writes the exact decimal digits of the finite, non-zero value 'val'
+// without leading or trailing zeros.  Returns the number of digits and sets
+// 'point' to the position of the decimal point relative to the first digit,
+// so val = 0.DIGITS * 10^point.
+int exactDigits(double val, char *digits, int *point) {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    int biased = (int)((bits >> 52) & 0x7ff);
+    uint64_t m = bits & ((1ull << 52) - 1);
+    int e;
+    if (biased) {
+        m |= 1ull << 52;
+        e = biased - 1075;
+    } else {
+        e = -1074;
+    }
+    while (!(m & 1)) {
+        m >>= 1;
+        ++e;
+    }
+
+    // val = m * 2^e, for a negative e that's m * 5^-e / 10^-e.
+    BigInt big(m);
+    if (e >= 0)
+        big.shiftLeft(e);
+    else
+        big.mulPow5(-e);
+
+    // extract nine digits at a time from the bottom into the end of
+    // 'digits', then move them to the front.
+    char *end = digits + MAX_DIGITS, *p = end;
+    while (big.size) {
+        uint32_t chunk = big.divSmall(1000000000);
+        for (int i = 0; i < 9; ++i) {
+            *--p = '0' + chunk % 10;
+            chunk /= 10;
+        }
+    }
+    while (*p == '0')
+        ++p;
+    int count = end - p;
+    memmove(digits, p, count);
+
+    *point = count + (e < 0 ? e : 0);
+    while (digits[count - 1] == '0')
+        --count;
+    return count;
+}
+
+// Rounds the digits to the first 'keep' of them, half to even.  Returns the
+// new digit count (without trailing zeros) and adjusts 'point' if the
+// rounding carries into a new leading digit.
+int roundDigits(char *digits, int count, int keep, int *point) {
+    if (keep >= count)
+        return count;
+    if (keep < 0)
+        return 0;
+
+    bool up;
+    char first = digits[keep];
+    if (first != '5')
+        up = first > '5';
+    else
+        // the digits have no trailing zeros, so anything after the 5 makes
+        // it more than half.
+        up = keep + 1 < count || (keep && (digits[keep - 1] - '0') % 2);
+
+    count = keep;
+    if (up) {
+        int i = keep - 1;
+        while (i >= 0 && digits[i] == '9')
+            --i;
+        if (i >= 0) {
+            ++digits[i];
+            count = i + 1;
+        } else {
+            digits[0] = '1';
+            count = 1;
+            ++*point;
+        }
+    }
+    while (count && digits[count - 1] == '0')
+        --count;
+    return count;
+}
+
+// Returns the digit at 'index' or '0' if it's outside of the digits.
+inline char digitAt(const char *digits, int count, int index) {
+    return index >= 0 && index < count ? digits[index] : '0';
+}
+
+void writeFixed(Out &out, const char *digits, int count, int point,
+                int precision
+                ) {
+    if (point <= 0) {
+        out.put('0');
+    } else {
+        for (int i = 0; i < point; ++i)
+            out.put(digitAt(digits, count, i));
+    }
+    if (precision > 0) {
+        out.put('.');
+        for (int i = point; i < point + precision; ++i)
+            out.put(digitAt(digits, count, i));
+    }
+}
+
+void writeScientific(Out &out, const char *digits, int count, int point,
+                     int precision
+                     ) {
+    out.put(count ? digits[0] : '0');
+    if (precision > 0) {
+        out.put('.');
+        for (int i = 1; i <= precision; ++i)
+            out.put(digitAt(digits, count, i));
+    }
+    out.putExponent(count ? point - 1 : 0);
+}
+
+// Splits 'val' into its sign and finiteness for the formatters.  Returns
+// true if the value was written as a special value.
+bool handleSpecial(Out &out, double val, bool *negative) {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    *negative = bits >> 63;
+    if (((bits >> 52) & 0x7ff) == 0x7ff)
+        return putSpecial(out, *negative, bits & ((1ull << 52) - 1));
+    return false;
+}
+
+enum Style { fixedStyle, scientificStyle, generalStyle };
+
+int formatPrecision(double val, int precision, char *buf, unsigned int size,
+                    Style style
+                    ) {
+    Out out(buf, size);
+    bool negative;
+    if (handleSpecial(out, val, &negative))
+        return out.pos;
+    if (precision < 0)
+        precision = 6;
+    else if (precision > 1000)
+        precision = 1000;
+
+    char digits[MAX_DIGITS];
+    int count = 0, point = 1;
+    if (val != 0)
+        count = exactDigits(val, digits, &point);
+
+    if (negative)
+        out.put('-');
+    switch (style) {
+        case fixedStyle:
+            count = roundDigits(digits, count, point + precision, &point);
+            writeFixed(out, digits, count, point, precision);
+            break;
+        case scientificStyle:
+            count = roundDigits(digits, count, precision + 1, &point);
+            writeScientific(out, digits, count, point, precision);
+            break;
+        case generalStyle: {
+            if (!precision)
+                precision = 1;
+            count = roundDigits(digits, count, precision, &point);
+            int exp = count ? point - 1 : 0;
+            if (exp >= -4 && exp < precision)
+                writeFixed(out, digits, count, point,
+                           count > point ? count - point : 0
+                           );
+            else
+                writeScientific(out, digits, count, point,
+                                count ? count - 1 : 0
+                                );
+            break;
+        }
+    }
+    return out.pos;
+}
+
+// ---- Parsing ----
+
+const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const float exactPowersOfTen32[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+const int MIN_POW10 = -348, MAX_POW10 = 347;
+
+inline bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// The result of scanning a number.
+struct Scanned {
+    enum Kind { invalid, number, special } kind;
+    bool negative;
+
+    // the number is mantissa * 10^exponent, 'truncated' is true if digits
+    // beyond the 19th were dropped from the mantissa.
+    uint64_t mantissa;
+    int exponent;
+    bool truncated;
+
+    // for specials, the value.
+    double specialValue;
+
+    // the part of the input that strtod() should see if we can't decide.
+    const char *start, *end;
+};
+
+Scanned scan(const char *p, const char *end) {
+    Scanned result;
+    result.kind = Scanned::invalid;
+    result.negative = false;
+    result.mantissa = 0;
+    result.exponent = 0;
+    result.truncated = false;
+
+    while (p < end && isSpace(*p))
+        ++p;
+    while (end > p && isSpace(end[-1]))
+        --end;
+    result.start = p;
+    result.end = end;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        result.negative = *p == '-';
+        ++p;
+    }
+
+    // specials and hex floats are rare, strtod() deals with them.
+    if ((p < end && ((*p | 0x20) == 'i' || (*p | 0x20) == 'n')) ||
+        (end - p > 1 && p[0] == '0' && (p[1] | 0x20) == 'x')
+        ) {
+        result.kind = Scanned::special;
+        return result;
+    }
+
+    int digitCount = 0;
+    bool sawDigit = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        sawDigit = true;
+        if (digitCount < 19) {
+            result.mantissa = result.mantissa * 10 + (*p - '0');
+            if (result.mantissa)
+                ++digitCount;
+        } else {
+            result.truncated |= *p != '0';
+            ++result.exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            sawDigit = true;
+            if (digitCount < 19) {
+                result.mantissa = result.mantissa * 10 + (*p - '0');
+                if (result.mantissa)
+                    ++digitCount;
+                --result.exponent;
+            } else {
+                result.truncated |= *p != '0';
+            }
+        }
+    }
+    if (!sawDigit)
+        return result;
+
+    if (p < end && (*p | 0x20) == 'e') {
+        ++p;
+        bool negExp = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negExp = *p == '-';
+            ++p;
+        }
+        if (p == end || *p < '0' || *p > '9')
+            return result;
+        int exp = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            // clamp it, anything this big is zero or infinite anyway.
+            if (exp < 100000)
+                exp = exp * 10 + (*p - '0');
+        result.exponent += negExp ? -exp : exp;
+    }
+
+    if (p != end)
+        return result;
+    result.kind = Scanned::number;
+    return result;
+}
+
+// Eisel-Lemire for a mantissa of up to 19 digits.  'mantissaBits' and
+// 'bias' describe the target format, the result is returned as its IEEE
+// bit pattern (without the sign).  Returns false if it can't decide the
+// rounding or the result isn't a normal number.
+bool eiselLemire(uint64_t man, int exp10, int mantissaBits, int bias,
+                 uint64_t *result
+                 ) {
+    if (exp10 < MIN_POW10 || exp10 > MAX_POW10)
+        return false;
+
+    int clz = leadingZeros64(man);
+    man <<= clz;
+    uint64_t retExp2 =
+        (uint64_t)(((217706 * exp10) >> 16) + 64 + bias) - clz;
+
+    const uint64_t *pow = POW10_128[exp10 - MIN_POW10];
+    int shift = 64 - mantissaBits - 3;
+    uint64_t mask = (1ull << shift) - 1;
+
+    uint64_t xHi, xLo = umul128(man, pow[1], &xHi);
+    if ((xHi & mask) == mask && xLo + man < man) {
+        uint64_t yHi, yLo = umul128(man, pow[0], &yHi);
+        uint64_t mergedHi = xHi, mergedLo = xLo + yHi;
+        if (mergedLo < xLo)
+            ++mergedHi;
+        if ((mergedHi & mask) == mask && mergedLo + 1 == 0 &&
+            yLo + man < man
+            )
+            return false;
+        xHi = mergedHi;
+        xLo = mergedLo;
+    }
+
+    uint64_t msb = xHi >> 63;
+    uint64_t retMantissa = xHi >> (msb + shift);
+    retExp2 -= 1 ^ msb;
+
+    // exactly half way between two values, we don't know which way to go.
+    if (xLo == 0 && (xHi & mask) == 0 && (retMantissa & 3) == 1)
+        return false;
+
+    retMantissa += retMantissa & 1;
+    retMantissa >>= 1;
+    if (retMantissa >> (mantissaBits + 1)) {
+        retMantissa >>= 1;
+        ++retExp2;
+    }
+
+    // zero means a subnormal, all ones an infinity.
+    uint64_t maxExp = 2 * bias + 1;
+    if (retExp2 - 1 >= maxExp - 1)
+        return false;
+    *result = (retExp2 << mantissaBits) |
+              (retMantissa & ((1ull << mantissaBits) - 1));
+    return true;
+}
+
+// Copies the text to a null terminated buffer for strtod() and strtof().
+// eiselLemire() doesn't produce subnormals, so they all come through here.
+template <typename T>
+T parseFallback(const Scanned &s, T (*convert)(const char *, char **)) {
+    char local[1024];
+    unsigned int len = s.end - s.start;
+    char *text = len < sizeof(local) ? local : (char *)malloc(len + 1);
+    memcpy(text, s.start, len);
+    text[len] = 0;
+    errno = 0;
+    char *end;
+    T result = convert(text, &end);
+    if (end != text + len) {
+        errno = EINVAL;
+        result = 0;
+    } else if (errno == ERANGE && result != 0 &&
+               result - result == result - result
+               ) {
+        // glibc also reports inexact subnormal results, we only report
+        // overflow and underflow to zero.
+        errno = 0;
+    }
+    if (text != local)
+        free(text);
+    return result;
+}
+
+double strtodWrapper(const char *text, char **end) {
+    return strtod(text, end);
+}
+
+float strtofWrapper(const char *text, char **end) {
+    return strtof(text, end);
+}
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+int formatFloat64(double val, char *buf, unsigned int size) {
+    Out out(buf, size);
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    bool negative = bits >> 63;
+    int biased = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantissa = bits & ((1ull << 52) - 1);
+
+    if (biased == 0x7ff) {
+        putSpecial(out, negative, mantissa);
+        return out.pos;
+    }
+    if (!biased && !mantissa) {
+        if (negative)
+            out.put('-');
+        out.put("0.0", 3);
+        return out.pos;
+    }
+
+    // Small integers are common and trivial.
+    if (biased >= 1023 && biased < 1023 + 52) {
+        int fractionBits = 1075 - biased;
+        uint64_t m2 = mantissa | (1ull << 52);
+        if (!(m2 & ((1ull << fractionBits) - 1))) {
+            Decimal dec = {m2 >> fractionBits, 0};
+            while (dec.digits % 10 == 0) {
+                dec.digits /= 10;
+                ++dec.exponent;
+            }
+            return writeShortest(out, negative, dec);
+        }
+    }
+
+    Decimal dec;
+    if (biased)
+        dec = shortestDecimal(mantissa | (1ull << 52), biased - 1075,
+                              mantissa != 0 || biased <= 1
+                              );
+    else
+        dec = shortestDecimal(mantissa, -1074, true);
+    return writeShortest(out, negative, dec);
+}
+
+int formatFloat32(float val, char *buf, unsigned int size) {
+    Out out(buf, size);
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    bool negative = bits >> 31;
+    int biased = (int)((bits >> 23) & 0xff);
+    uint32_t mantissa = bits & ((1u << 23) - 1);
+
+    if (biased == 0xff) {
+        putSpecial(out, negative, mantissa);
+        return out.pos;
+    }
+    if (!biased && !mantissa) {
+        if (negative)
+            out.put('-');
+        out.put("0.0", 3);
+        return out.pos;
+    }
+
+    Decimal dec;
+    if (biased)
+        dec = shortestDecimal(mantissa | (1u << 23), biased - 150,
+                              mantissa != 0 || biased <= 1
+                              );
+    else
+        dec = shortestDecimal(mantissa, -149, true);
+    return writeShortest(out, negative, dec);
+}
+
+int formatFixed(double val, int precision, char *buf, unsigned int size) {
+    return formatPrecision(val, precision, buf, size, fixedStyle);
+}
+
+int formatScientific(double val, int precision, char *buf,
+                     unsigned int size
+                     ) {
+    return formatPrecision(val, precision, buf, size, scientificStyle);
+}
+
+int formatGeneral(double val, int precision, char *buf, unsigned int size) {
+    return formatPrecision(val, precision, buf, size, generalStyle);
+}
+
+double parseFloat64(const char *text, unsigned int size) {
+    Scanned s = scan(text, text + size);
+    errno = 0;
+    if (s.kind == Scanned::invalid) {
+        errno = EINVAL;
+        return 0;
+    } else if (s.kind == Scanned::special) {
+        return parseFallback<double>(s, strtodWrapper);
+    }
+
+    double result;
+    if (!s.mantissa) {
+        result = 0;
+    } else if (!s.truncated && s.mantissa <= (1ull << 53) &&
+               s.exponent >= -22 && s.exponent <= 22
+               ) {
+        // both operands are exact, so the result is correctly rounded.
+        result = (double)s.mantissa;
+        if (s.exponent < 0)
+            result /= exactPowersOfTen[-s.exponent];
+        else
+            result *= exactPowersOfTen[s.exponent];
+    } else {
+        uint64_t bits;
+        if (s.truncated ||
+            !eiselLemire(s.mantissa, s.exponent, 52, 1023, &bits)
+            )
+            return parseFallback<double>(s, strtodWrapper);
+        memcpy(&result, &bits, sizeof(result));
+    }
+    return s.negative ? -result : result;
+}
+
+float parseFloat32(const char *text, unsigned int size) {
+    Scanned s = scan(text, text + size);
+    errno = 0;
+    if (s.kind == Scanned::invalid) {
+        errno = EINVAL;
+        return 0;
+    } else if (s.kind == Scanned::special) {
+        return parseFallback<float>(s, strtofWrapper);
+    }
+
+    float result;
+    if (!s.mantissa) {
+        result = 0;
+    } else if (!s.truncated && s.mantissa <= (1u << 24) &&
+               s.exponent >= -10 && s.exponent <= 10
+               ) {
+        result = (float)s.mantissa;
+        if (s.exponent < 0)
+            result /= exactPowersOfTen32[-s.exponent];
+        else
+            result *= exactPowersOfTen32[s.exponent];
+    } else {
+        uint64_t bits;
+        if (s.truncated ||
+            !eiselLemire(s.mantissa, s.exponent, 23, 127, &bits)
+            )
+            return parseFallback<float>(s, strtofWrapper);
+        uint32_t bits32 = (uint32_t)bits;
+        memcpy(&result, &bits32, sizeof(result));
+    }
+    return s.negative ? -result : result;
+}
+
+void addFloatFormat(Module *mod) {
+    Type *intType = mod->getIntType();
+    Type *uintType = mod->getUintType();
+    Type *byteptrType = mod->getByteptrType();
+    Type *float32Type = mod->getFloat32Type();
+    Type *float64Type = mod->getFloat64Type();
+
+    Func *f = mod->addFunc(intType, "formatFloat64",
+                           (void *)formatFloat64
+                           );
+    f->addArg(float64Type, "val");
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+
+    f = mod->addFunc(intType, "formatFloat32", (void *)formatFloat32);
+    f->addArg(float32Type, "val");
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+
+    struct { const char *name; void *func; } precisionFuncs[] = {
+        {"formatFixed", (void *)formatFixed},
+        {"formatScientific", (void *)formatScientific},
+        {"formatGeneral", (void *)formatGeneral}
+    };
+    for (int i = 0; i < 3; ++i) {
+        f = mod->addFunc(intType, precisionFuncs[i].name,
+                         precisionFuncs[i].func
+                         );
+        f->addArg(float64Type, "val");
+        f->addArg(intType, "precision");
+        f->addArg(byteptrType, "buf");
+        f->addArg(uintType, "size");
+    }
+
+    f = mod->addFunc(float64Type, "parseFloat64", (void *)parseFloat64);
+    f->addArg(byteptrType, "text");
+    f->addArg(uintType, "size");
+
+    f = mod->addFunc(float32Type, "parseFloat32", (void *)parseFloat32);
+    f->addArg(byteptrType, "text");
+    f->addArg(uintType, "size");
+}
+
+}} // namespace crack::runtime
@@ -0,0 +1,52 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Locale independent conversion of floating point numbers to and from text.
+
+#ifndef _runtime_FloatFormat_h_
+#define _runtime_FloatFormat_h_
+
+namespace crack { namespace ext {
+    class Module;
+}}
+
+namespace crack { namespace runtime {
+
+// All of the formatting functions write at most 'size' bytes to 'buf' (no
+// null terminator) and return the length of the complete result, so if the
+// return value is greater than 'size' the output was truncated.  NaNs and
+// infinities are written as "nan", "-nan", "inf" and "-inf".
+
+// Writes the shortest string that parses back to exactly 'val'.  Numbers
+// with a decimal exponent from -4 to 15 are written in positional notation
+// with at least one digit after the point ("0.001", "12.0"), the others in
+// scientific notation ("1e+16", "2.5e-07").  The result never needs more
+// than 24 bytes.
+int formatFloat64(double val, char *buf, unsigned int size);
+int formatFloat32(float val, char *buf, unsigned int size);
+
+// Equivalent to printf() "%.*f", "%.*e" and "%.*g" in the C locale, with
+// exact round half to even rounding of the binary value.  'precision' is
+// limited to 1000.
+int formatFixed(double val, int precision, char *buf, unsigned int size);
+int formatScientific(double val, int precision, char *buf, unsigned int size);
+int formatGeneral(double val, int precision, char *buf, unsigned int size);
+
+// Parses the 'size' bytes at 's' as a decimal number, correctly rounded.
+// Accepts the same syntax as strtod() including "inf", "nan" and hex
+// floats, with optional surrounding whitespace.  Sets errno to 0 on
+// success, to EINVAL (and returns 0) if the text is not a number and to
+// ERANGE if the value overflows or underflows to zero.  Unlike glibc's
+// strtod(), a result that is subnormal but not zero isn't an error.
+double parseFloat64(const char *s, unsigned int size);
+float parseFloat32(const char *s, unsigned int size);
+
+// Adds the functions above to 'mod'.
+void addFloatFormat(crack::ext::Module *mod);
+
+}} // namespace crack::runtime
+
+#endif
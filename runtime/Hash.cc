@@ -0,0 +1,151 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Hash function for byte buffers.
+//
+// Unseeded, this is MurmurHash64A, folded to 32 bits.  It mixes a whole word
+// per multiply and distributes common prefixes (paths, URLs) well, which the
+// byte-at-a-time rotate and xor hash that we used before did not.
+//
+// Seeding MurmurHash doesn't protect against hash flooding: its collisions
+// can be found without knowing the seed.  When a seed is set we use
+// SipHash-2-4 instead, a keyed pseudorandom function designed for hash
+// tables, though it is slower.
+
+#include "Hash.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+    const uint64_t M = 0xc6a4a7935bd1e995ULL;
+    const int R = 47;
+
+    // The SipHash key.  The seed is the first half, the whole key is zero if
+    // the hash is unseeded.
+    uint64_t key[2];
+
+    bool initKey() {
+        const char *val = getenv("CRACK_HASH_SEED");
+        if (!val)
+            return false;
+
+        if (strcasecmp(val, "random")) {
+            // derive the second half of the key from the seed so that a
+            // given seed always produces the same hashes.
+            key[0] = strtoull(val, 0, 0);
+            uint64_t k = key[0] * M;
+            key[1] = (k ^ k >> R) * M;
+            return key[0] || key[1];
+        }
+
+        int fd = open("/dev/urandom", O_RDONLY);
+        if (fd == -1 || read(fd, key, sizeof(key)) != sizeof(key)) {
+            key[0] = static_cast<uint64_t>(time(0)) << 32 ^ getpid();
+            key[1] = reinterpret_cast<uintptr_t>(&fd) * M;
+        }
+        if (fd != -1)
+            close(fd);
+        return true;
+    }
+
+    bool seeded = initKey();
+
+    inline uint64_t rotl(uint64_t x, int b) {
+        return x << b | x >> (64 - b);
+    }
+
+    inline void sipRound(uint64_t &v0, uint64_t &v1, uint64_t &v2,
+                         uint64_t &v3
+                         ) {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+uint64_t sipHash(const char *data, unsigned int size, uint64_t k0,
+                 uint64_t k1
+                 ) {
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL,
+             v1 = k1 ^ 0x646f72616e646f6dULL,
+             v2 = k0 ^ 0x6c7967656e657261ULL,
+             v3 = k1 ^ 0x7465646279746573ULL;
+
+    const char *end = data + (size & ~7U);
+    for (; data != end; data += 8) {
+        uint64_t m;
+        memcpy(&m, data, 8);
+        v3 ^= m;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    uint64_t b = static_cast<uint64_t>(size) << 56, tail = 0;
+    memcpy(&tail, data, size & 7);
+    b |= tail;
+    v3 ^= b;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; ++i)
+        sipRound(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+unsigned int hashBytes(const char *data, unsigned int size) {
+    if (seeded) {
+        uint64_t h = sipHash(data, size, key[0], key[1]);
+        return static_cast<unsigned int>(h ^ h >> 32);
+    }
+
+    uint64_t h = size * M;
+
+    const char *end = data + (size & ~7U);
+    for (; data != end; data += 8) {
+        // memcpy() keeps this safe for unaligned data, it compiles to a
+        // single load.
+        uint64_t k;
+        memcpy(&k, data, 8);
+
+        k *= M;
+        k ^= k >> R;
+        k *= M;
+
+        h ^= k;
+        h *= M;
+    }
+
+    if (unsigned int tail = size & 7) {
+        uint64_t k = 0;
+        memcpy(&k, data, tail);
+        h ^= k;
+        h *= M;
+    }
+
+    h ^= h >> R;
+    h *= M;
+    h ^= h >> R;
+    return static_cast<unsigned int>(h ^ h >> 32);
+}
+
+uint64_t getHashSeed() {
+    return key[0];
+}
+
+}} // namespace crack::runtime
@@ -0,0 +1,39 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Hash function for byte buffers.
+
+#ifndef _runtime_Hash_h_
+#define _runtime_Hash_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace crack { namespace runtime {
+
+// Returns a 32-bit hash of 'size' bytes at 'data'.  This is the hash used
+// for Buffer and String keys.  It processes the data eight bytes at a time.
+unsigned int hashBytes(const char *data, unsigned int size);
+
+// Returns the SipHash-2-4 of 'size' bytes at 'data' with the 128-bit key
+// 'k0', 'k1' (the first and second eight bytes of the key, read as
+// little-endian words).  Words of the data are read in native byte order,
+// so this matches the reference implementation on little-endian machines.
+// hashBytes() uses this when the hash is seeded.
+uint64_t sipHash(const char *data, unsigned int size, uint64_t k0,
+                 uint64_t k1
+                 );
+
+// Returns the seed of the hash function.  This is zero unless the
+// CRACK_HASH_SEED environment variable is set to a number or to "random".
+// A seeded hash is keyed SipHash, and with "random" a different key is
+// chosen for every process so that collisions can't be precomputed (hash
+// flooding).
+uint64_t getHashSeed();
+
+}} // namespace crack::runtime
+
+#endif
@@ -17,7 +17,12 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/mman.h>
+#include <sys/eventfd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <signal.h>
 #include <errno.h>
@@ -27,11 +32,20 @@
 #include "ext/Func.h"
 #include "ext/Module.h"
 #include "ext/Type.h"
+#include "Alloc.h"
+#include "AllocProfiler.h"
+#include "Atomic.h"
+#include "BufferSearch.h"
+#include "Cycles.h"
+#include "Hash.h"
 #include "Dir.h"
 #include "Util.h"
 #include "Net.h"
+#include "Numeric.h"
 #include "Exceptions.h"
+#include "FloatFormat.h"
 #include "Process.h"
+#include "Profiler.h"
 using namespace crack::ext;
 using namespace crack::runtime;
 
@@ -396,7 +410,23 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     mod->addConstant(uint32Type, "INADDR_ANY", static_cast<int>(INADDR_ANY));
 
     mod->addConstant(intType, "EAGAIN", EAGAIN);
+    mod->addConstant(intType, "EINTR", EINTR);
     mod->addConstant(intType, "EWOULDBLOCK", EWOULDBLOCK);
+
+    // send() flags and TCP options.  The ones that are Linux specific are
+    // zero elsewhere so they can be passed unconditionally.
+    mod->addConstant(intType, "MSG_DONTWAIT", MSG_DONTWAIT);
+    mod->addConstant(intType, "IPPROTO_TCP", IPPROTO_TCP);
+    mod->addConstant(intType, "TCP_NODELAY", TCP_NODELAY);
+#ifdef __linux__
+    mod->addConstant(intType, "MSG_MORE", MSG_MORE);
+    mod->addConstant(intType, "MSG_NOSIGNAL", MSG_NOSIGNAL);
+    mod->addConstant(intType, "TCP_CORK", TCP_CORK);
+#else
+    mod->addConstant(intType, "MSG_MORE", 0);
+    mod->addConstant(intType, "MSG_NOSIGNAL", 0);
+    mod->addConstant(intType, "TCP_CORK", 0);
+#endif
     
     f = mod->addFunc(uint32Type, "makeIPV4", 
                      (void*)crack::runtime::makeIPV4);
@@ -679,6 +709,80 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     pollSetType->finish();
     // end PollSet
 
+    // begin epoll
+    f = mod->addFunc(intType, "epollCreate",
+                     (void *)crack::runtime::epollCreate
+                     );
+
+    f = mod->addFunc(intType, "epollCtl", (void *)crack::runtime::epollCtl);
+    f->addArg(intType, "epfd");
+    f->addArg(intType, "op");
+    f->addArg(intType, "fd");
+    f->addArg(intType, "events");
+
+    Type *epollEventsType = mod->addType("EpollEvents", 0);
+    f = epollEventsType->addStaticMethod(
+        epollEventsType,
+        "oper new",
+        (void *)crack::runtime::EpollEvents_create
+    );
+    f->addArg(uintType, "size");
+
+    f = epollEventsType->addMethod(voidType, "destroy",
+                                   (void *)crack::runtime::EpollEvents_destroy
+                                   );
+
+    f = epollEventsType->addMethod(voidType, "get",
+                                   (void *)crack::runtime::EpollEvents_get
+                                   );
+    f->addArg(uintType, "index");
+    f->addArg(pollEventType, "outputEntry");
+
+    f = epollEventsType->addMethod(intType, "wait",
+                                   (void *)crack::runtime::EpollEvents_wait
+                                   );
+    f->addArg(intType, "epfd");
+    f->addArg(uintType, "maxEvents");
+    f->addArg(timeValType, "tv");
+    epollEventsType->finish();
+
+#ifdef __linux__
+    mod->addConstant(intType, "EPOLLET", static_cast<int>(EPOLLET));
+    mod->addConstant(intType, "EPOLLONESHOT",
+                     static_cast<int>(EPOLLONESHOT)
+                     );
+    mod->addConstant(intType, "EPOLLRDHUP", static_cast<int>(EPOLLRDHUP));
+    mod->addConstant(intType, "EPOLL_CTL_ADD", EPOLL_CTL_ADD);
+    mod->addConstant(intType, "EPOLL_CTL_MOD", EPOLL_CTL_MOD);
+    mod->addConstant(intType, "EPOLL_CTL_DEL", EPOLL_CTL_DEL);
+#else
+    mod->addConstant(intType, "EPOLLET", 0);
+    mod->addConstant(intType, "EPOLLONESHOT", 0);
+    mod->addConstant(intType, "EPOLLRDHUP", 0);
+    mod->addConstant(intType, "EPOLL_CTL_ADD", 1);
+    mod->addConstant(intType, "EPOLL_CTL_MOD", 3);
+    mod->addConstant(intType, "EPOLL_CTL_DEL", 2);
+#endif
+    // end epoll
+
+    // begin timerfd
+    mod->addFunc(intType, "timerfdCreate",
+                 (void *)crack::runtime::timerfdCreate
+                 );
+
+    f = mod->addFunc(intType, "timerfdSet",
+                     (void *)crack::runtime::timerfdSet
+                     );
+    f->addArg(intType, "fd");
+    f->addArg(timeValType, "initial");
+    f->addArg(timeValType, "interval");
+
+    f = mod->addFunc(uint64Type, "timerfdRead",
+                     (void *)crack::runtime::timerfdRead
+                     );
+    f->addArg(intType, "fd");
+    // end timerfd
+
     // addrinfo
     Type *addrinfoType = mod->addType("AddrInfo", sizeof(addrinfo));
     f = addrinfoType->addStaticMethod(addrinfoType, "oper new", 
@@ -753,7 +857,141 @@ extern "C" void crack_runtime_cinit(Module *mod) {
 
     f = mod->addFunc(voidType, "free", (void *)free, "free");
     f->addArg(voidptrType, "size");
+
+    // object allocator
+    f = mod->addFunc(voidType, "freeObject", (void *)__CrackFree,
+                     "__CrackFree"
+                     );
+    f->addArg(voidptrType, "object");
+
+    mod->addConstant(intType, "ALLOCATOR_LIBC", libcAllocator);
+    mod->addConstant(intType, "ALLOCATOR_SIZE_CLASS", sizeClassAllocator);
+    mod->addFunc(intType, "getAllocatorType",
+                 (void *)crack::runtime::getAllocatorType
+                 );
+    mod->addFunc(uintType, "getAllocClassCount",
+                 (void *)crack::runtime::getAllocClassCount
+                 );
+    f = mod->addFunc(uintzType, "getAllocClassSize",
+                     (void *)crack::runtime::getAllocClassSize
+                     );
+    f->addArg(uintType, "sizeClass");
+    f = mod->addFunc(uint64Type, "getAllocCount",
+                     (void *)crack::runtime::getAllocCount
+                     );
+    f->addArg(uintType, "sizeClass");
+    f = mod->addFunc(uint64Type, "getFreeCount",
+                     (void *)crack::runtime::getFreeCount
+                     );
+    f->addArg(uintType, "sizeClass");
+    f = mod->addFunc(voidType, "dumpAllocProfile",
+                     (void *)crack::runtime::dumpAllocProfile
+                     );
+    f->addArg(intType, "fd");
+
+    // sampling profiler
+    f = mod->addFunc(boolType, "startProfiler",
+                     (void *)crack::runtime::startProfiler
+                     );
+    f->addArg(intType, "frequency");
+    f->addArg(uintType, "bufferSize");
+    mod->addFunc(voidType, "stopProfiler",
+                 (void *)crack::runtime::stopProfiler
+                 );
+    f = mod->addFunc(intType, "writeProfile",
+                     (void *)crack::runtime::writeProfile
+                     );
+    f->addArg(intType, "fd");
+    mod->addFunc(uintType, "getDroppedSamples",
+                 (void *)crack::runtime::getDroppedSamples
+                 );
+
+    // cycle collector candidate buffer
+    f = mod->addFunc(voidType, "addCycleCandidate",
+                     (void *)__CrackAddCycleCandidate,
+                     "__CrackAddCycleCandidate"
+                     );
+    f->addArg(voidptrType, "object");
+    f = mod->addFunc(voidType, "removeCycleCandidate",
+                     (void *)__CrackRemoveCycleCandidate,
+                     "__CrackRemoveCycleCandidate"
+                     );
+    f->addArg(voidptrType, "object");
+    mod->addFunc(voidptrType, "popCycleCandidate",
+                 (void *)crack::runtime::popCycleCandidate
+                 );
+    mod->addFunc(uintType, "getCycleCandidateCount",
+                 (void *)crack::runtime::getCycleCandidateCount
+                 );
+    mod->addFunc(voidType, "clearCycleCandidates",
+                 (void *)crack::runtime::clearCycleCandidates
+                 );
+
+    // buffer hashing
+    f = mod->addFunc(uintType, "hashBytes",
+                     (void *)crack::runtime::hashBytes
+                     );
+    f->addArg(byteptrType, "data");
+    f->addArg(uintType, "size");
+    f = mod->addFunc(uint64Type, "sipHash",
+                     (void *)crack::runtime::sipHash
+                     );
+    f->addArg(byteptrType, "data");
+    f->addArg(uintType, "size");
+    f->addArg(uint64Type, "k0");
+    f->addArg(uint64Type, "k1");
+    mod->addFunc(uint64Type, "getHashSeed",
+                 (void *)crack::runtime::getHashSeed
+                 );
     
+    // atomic operations on array elements
+    Type *intzArrayType;
+    {
+        std::vector<Type *> params(1);
+        params[0] = intzType;
+        intzArrayType = baseArrayType->getSpecialization(params);
+    }
+    intzArrayType->finish();
+    f = mod->addFunc(intzType, "atomicLoad",
+                     (void *)crack::runtime::atomicLoad
+                     );
+    f->addArg(intzArrayType, "addr");
+    f = mod->addFunc(voidType, "atomicStore",
+                     (void *)crack::runtime::atomicStore
+                     );
+    f->addArg(intzArrayType, "addr");
+    f->addArg(intzType, "val");
+    f = mod->addFunc(intzType, "atomicAdd",
+                     (void *)crack::runtime::atomicAdd
+                     );
+    f->addArg(intzArrayType, "addr");
+    f->addArg(intzType, "delta");
+    f = mod->addFunc(boolType, "atomicCompareAndSwap",
+                     (void *)crack::runtime::atomicCompareAndSwap
+                     );
+    f->addArg(intzArrayType, "addr");
+    f->addArg(intzType, "expected");
+    f->addArg(intzType, "val");
+
+    // mutexes for modules that can't use crack.threads.
+    mod->addFunc(voidptrType, "mutexNew", (void *)crack::runtime::mutexNew);
+    f = mod->addFunc(voidType, "mutexFree",
+                     (void *)crack::runtime::mutexFree
+                     );
+    f->addArg(voidptrType, "mutex");
+    f = mod->addFunc(voidType, "mutexLock",
+                     (void *)crack::runtime::mutexLock
+                     );
+    f->addArg(voidptrType, "mutex");
+    f = mod->addFunc(boolType, "mutexTryLock",
+                     (void *)crack::runtime::mutexTryLock
+                     );
+    f->addArg(voidptrType, "mutex");
+    f = mod->addFunc(voidType, "mutexUnlock",
+                     (void *)crack::runtime::mutexUnlock
+                     );
+    f->addArg(voidptrType, "mutex");
+
     f = mod->addFunc(voidType, "strcpy", (void *)strcpy, "strcpy");
     f->addArg(byteptrType, "dst");
     f->addArg(byteptrType, "src");
@@ -763,7 +1001,11 @@ extern "C" void crack_runtime_cinit(Module *mod) {
 
     f = mod->addFunc(byteptrType, "malloc", (void *)malloc, "malloc");
     f->addArg(uintType, "size");
-    
+
+    f = mod->addFunc(byteptrType, "realloc", (void *)realloc, "realloc");
+    f->addArg(byteptrType, "buf");
+    f->addArg(uintType, "size");
+
     f = mod->addFunc(byteptrType, "memcpy", (void *)memcpy, "memcpy");
     f->addArg(byteptrType, "dst");
     f->addArg(byteptrType, "src");
@@ -807,6 +1049,50 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     f->addArg(byteptrType, "buf");
     f->addArg(uintType, "count");
 
+    f = mod->addFunc(intType, "writePair",
+                     (void *)crack::runtime::writePair
+                     );
+    f->addArg(intType, "fd");
+    f->addArg(byteptrType, "first");
+    f->addArg(uintType, "firstSize");
+    f->addArg(byteptrType, "second");
+    f->addArg(uintType, "secondSize");
+
+    Type *uintArrayType;
+    {
+        std::vector<Type *> params(1);
+        params[0] = uintType;
+        uintArrayType = baseArrayType->getSpecialization(params);
+    }
+    uintArrayType->finish();
+    f = mod->addFunc(intType, "writeVector",
+                     (void *)crack::runtime::writeVector
+                     );
+    f->addArg(intType, "fd");
+    f->addArg(byteptrArrayType, "bufs");
+    f->addArg(uintArrayType, "sizes");
+    f->addArg(uintType, "count");
+
+    f = mod->addFunc(intType, "sendVector",
+                     (void *)crack::runtime::sendVector
+                     );
+    f->addArg(intType, "s");
+    f->addArg(byteptrArrayType, "bufs");
+    f->addArg(uintArrayType, "sizes");
+    f->addArg(uintType, "count");
+    f->addArg(intType, "flags");
+
+    f = mod->addFunc(int64Type, "sendFile",
+                     (void *)crack::runtime::sendFile
+                     );
+    f->addArg(intType, "s");
+    f->addArg(intType, "fd");
+    f->addArg(int64Type, "offset");
+    f->addArg(uintzType, "count");
+
+    f = mod->addFunc(intType, "isatty", (void *)isatty, "isatty");
+    f->addArg(intType, "fd");
+
     f = mod->addFunc(intType, "utimes", (void *)crack::runtime::setUtimes);
     f->addArg(byteptrType, "path");
     f->addArg(int64Type, "atime");
@@ -816,11 +1102,22 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     f = mod->addFunc(voidType, "exit", (void *)exit, "exit");
     f->addArg(intType, "status");
 
+    f = mod->addFunc(intType, "atexit", (void *)atexit, "atexit");
+    f->addArg(voidptrType, "func");
+
     f = mod->addFunc(intType, "setNonBlocking",
                      (void *)crack::runtime::setNonBlocking);
     f->addArg(intType, "fd");
     f->addArg(boolType, "val");
 
+    // event file descriptors
+    f = mod->addFunc(intType, "eventfd", (void *)eventfd, "eventfd");
+    f->addArg(uintType, "initval");
+    f->addArg(intType, "flags");
+    mod->addConstant(intType, "EFD_CLOEXEC", EFD_CLOEXEC);
+    mod->addConstant(intType, "EFD_NONBLOCK", EFD_NONBLOCK);
+    mod->addConstant(intType, "EFD_SEMAPHORE", EFD_SEMAPHORE);
+
     // mmap
     f = mod->addFunc(voidptrType, "mmap", (void *)mmap, "mmap");
     f->addArg(voidptrType, "start");
@@ -831,10 +1128,21 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     f->addArg(uintzType, "offset");
 
     // munmap
-    f = mod->addFunc(intType, "munmap", (void *)mmap, "munmap");
+    f = mod->addFunc(intType, "munmap", (void *)munmap, "munmap");
     f->addArg(voidptrType, "start");
     f->addArg(uintzType, "length"); 
 
+    // madvise
+    f = mod->addFunc(intType, "madvise", (void *)madvise, "madvise");
+    f->addArg(voidptrType, "start");
+    f->addArg(uintzType, "length");
+    f->addArg(intType, "advice");
+
+    f = mod->addFunc(int64Type, "fileSize",
+                     (void *)crack::runtime::fileSize
+                     );
+    f->addArg(intType, "fd");
+
     // mmap protection flags
     mod->addConstant(intType, "PROT_NONE", PROT_NONE);
     mod->addConstant(intType, "PROT_EXEC", PROT_EXEC);
@@ -847,8 +1155,24 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     mod->addConstant(intType, "MAP_SHARED", MAP_SHARED);
     mod->addConstant(intType, "MAP_PRIVATE", MAP_PRIVATE);
 
+    // madvise advice
+    mod->addConstant(intType, "MADV_NORMAL", MADV_NORMAL);
+    mod->addConstant(intType, "MADV_RANDOM", MADV_RANDOM);
+    mod->addConstant(intType, "MADV_SEQUENTIAL", MADV_SEQUENTIAL);
+    mod->addConstant(intType, "MADV_WILLNEED", MADV_WILLNEED);
+    mod->addConstant(intType, "MADV_DONTNEED", MADV_DONTNEED);
+
     // Add math functions
     crack_runtime__math_cinit(mod);
+
+    // Add the vectorized array kernels
+    crack::runtime::addNumericKernels(mod);
+
+    // Add float formatting and parsing
+    crack::runtime::addFloatFormat(mod);
+
+    // Add the vectorized buffer searches
+    crack::runtime::addBufferSearch(mod);
     
     // Add time functions
     crack_runtime_time_cinit(mod);
@@ -965,6 +1289,8 @@ extern "C" void crack_runtime_cinit(Module *mod) {
     f->addArg(intType, "pid");
     f->addArg(intType, "sig");
 
+    mod->addFunc(intType, "getpid", (void *)getpid, "getpid");
+
     f = mod->addFunc(byteptrType, "iconv",
                            (void*)&crack::runtime::crk_iconv);
     f->addArg(uintType, "targetCharSize");
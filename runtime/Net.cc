@@ -14,6 +14,12 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/timerfd.h>
+#endif
 #include <poll.h>
 #include <arpa/inet.h>
 #ifdef HAVE_STRING_H
@@ -186,6 +192,53 @@ int setsockopt_int(int fd, int level, int optname, int val) {
     return setsockopt(fd, level, optname, &val, sizeof(val));
 }
 
+int sendVector(int s, char **bufs, unsigned int *sizes, unsigned int count,
+               int flags
+               ) {
+    struct iovec iov[64];
+    if (count > 64)
+        count = 64;
+    for (unsigned int i = 0; i < count; ++i) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = sizes[i];
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    ssize_t rc;
+    do {
+        rc = sendmsg(s, &msg, flags);
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+}
+
+int64_t sendFile(int s, int fd, int64_t offset, size_t count) {
+#ifdef __linux__
+    off_t off = offset;
+    ssize_t rc;
+    do {
+        rc = sendfile(s, fd, &off, count);
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+#else
+    // no sendfile(), copy one block through a buffer.
+    char buf[65536];
+    if (count > sizeof(buf))
+        count = sizeof(buf);
+    ssize_t rc = pread(fd, buf, count, offset);
+    if (rc <= 0)
+        return rc;
+    ssize_t sent;
+    do {
+        sent = send(s, buf, rc, 0);
+    } while (sent < 0 && errno == EINTR);
+    return sent;
+#endif
+}
+
 pollfd *PollSet_create(unsigned int size) {
     return (pollfd *)calloc(size, sizeof(struct pollfd));
 }
@@ -258,6 +311,114 @@ int PollSet_poll(struct pollfd *fds, unsigned int nfds, TimeVal *tv,
 #endif
 }
 
+#ifdef __linux__
+
+int epollCreate() {
+    return epoll_create1(EPOLL_CLOEXEC);
+}
+
+int epollCtl(int epfd, int op, int fd, int events) {
+    epoll_event evt;
+    evt.events = events;
+    evt.data.u64 = 0;
+    evt.data.fd = fd;
+    return epoll_ctl(epfd, op, fd, &evt);
+}
+
+EpollEvents *EpollEvents_create(unsigned int size) {
+    return (EpollEvents *)calloc(size, sizeof(epoll_event));
+}
+
+void EpollEvents_destroy(EpollEvents *events) {
+    free(events);
+}
+
+void EpollEvents_get(EpollEvents *events, unsigned int index,
+                     PollEvt *outputEntry
+                     ) {
+    epoll_event &elem = ((epoll_event *)events)[index];
+    outputEntry->fd = elem.data.fd;
+    outputEntry->revents = elem.events;
+}
+
+int EpollEvents_wait(EpollEvents *events, int epfd, unsigned int maxEvents,
+                     TimeVal *tv
+                     ) {
+    // epoll_wait() takes milliseconds, round up so that a short timeout
+    // doesn't turn into a busy loop.
+    int timeout = -1;
+    if (tv)
+        timeout = tv->secs * 1000 + (tv->nsecs + 999999) / 1000000;
+    return epoll_wait(epfd, (epoll_event *)events, maxEvents, timeout);
+}
+
+int timerfdCreate() {
+    return timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+int timerfdSet(int fd, TimeVal *initial, TimeVal *interval) {
+    itimerspec spec;
+    spec.it_value.tv_sec = initial ? initial->secs : 0;
+    spec.it_value.tv_nsec = initial ? initial->nsecs : 0;
+    spec.it_interval.tv_sec = interval ? interval->secs : 0;
+    spec.it_interval.tv_nsec = interval ? interval->nsecs : 0;
+    return timerfd_settime(fd, 0, &spec, 0);
+}
+
+uint64_t timerfdRead(int fd) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+    return expirations;
+}
+
+#else
+
+int epollCreate() {
+    errno = ENOSYS;
+    return -1;
+}
+
+int epollCtl(int epfd, int op, int fd, int events) {
+    errno = ENOSYS;
+    return -1;
+}
+
+EpollEvents *EpollEvents_create(unsigned int size) {
+    return 0;
+}
+
+void EpollEvents_destroy(EpollEvents *events) {}
+
+void EpollEvents_get(EpollEvents *events, unsigned int index,
+                     PollEvt *outputEntry
+                     ) {
+    assert(0 && "no epoll");
+}
+
+int EpollEvents_wait(EpollEvents *events, int epfd, unsigned int maxEvents,
+                     TimeVal *tv
+                     ) {
+    errno = ENOSYS;
+    return -1;
+}
+
+int timerfdCreate() {
+    errno = ENOSYS;
+    return -1;
+}
+
+int timerfdSet(int fd, TimeVal *initial, TimeVal *interval) {
+    errno = ENOSYS;
+    return -1;
+}
+
+uint64_t timerfdRead(int fd) {
+    return 0;
+}
+
+#endif
+
 sigset_t *SigSet_create() {
     return (sigset_t *)malloc(sizeof(sigset_t));
 }
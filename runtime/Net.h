@@ -95,6 +95,19 @@ int bind(int s, SockAddr *addr);
 int accept(int s, SockAddr *addr);
 int setsockopt_int(int fd, int level, int optname, int val);
 
+// Sends the first 'count' buffers (at most 64) on socket 's' with a single
+// sendmsg() call, passing 'flags' (e.g. MSG_MORE).  Doesn't retry short
+// writes.  Returns the number of bytes sent or -1 on error.
+int sendVector(int s, char **bufs, unsigned int *sizes, unsigned int count,
+               int flags
+               );
+
+// Sends up to 'count' bytes of the file open on 'fd', starting at 'offset',
+// to socket 's'.  This uses sendfile() where it is available so the data
+// isn't copied through user space.  Returns the number of bytes sent or -1
+// on error.
+int64_t sendFile(int s, int fd, int64_t offset, size_t count);
+
 sigset_t *SigSet_create();
 void SigSet_destroy(sigset_t *sigmask);
 int SigSet_empty(sigset_t *sigmask);
@@ -120,6 +133,30 @@ int PollSet_poll(struct pollfd *fds, unsigned int nfds, TimeVal *tv,
                  sigset_t *sigmask
                  );
 
+// epoll support.  An EpollEvents is an array of epoll_event structures that
+// epoll_wait() stores the ready events in.  On systems without epoll these
+// all fail with ENOSYS.
+struct EpollEvents;
+int epollCreate();
+int epollCtl(int epfd, int op, int fd, int events);
+EpollEvents *EpollEvents_create(unsigned int size);
+void EpollEvents_destroy(EpollEvents *events);
+void EpollEvents_get(EpollEvents *events, unsigned int index,
+                     PollEvt *outputEntry
+                     );
+int EpollEvents_wait(EpollEvents *events, int epfd, unsigned int maxEvents,
+                     TimeVal *tv
+                     );
+
+// timerfd support, fails with ENOSYS where timerfd isn't available.
+// timerfdCreate() creates a non-blocking timer on the monotonic clock.
+// timerfdSet() arms it to expire after 'initial' and then every 'interval'
+// (if 'interval' is null or zero, the timer expires once).  A zero
+// 'initial' disarms it.  timerfdRead() returns the number of expirations
+// since the last call, zero if there were none.
+int timerfdCreate();
+int timerfdSet(int fd, TimeVal *initial, TimeVal *interval);
+uint64_t timerfdRead(int fd);
 
 addrinfo *AddrInfo_create(const char *host, const char *service,
                           addrinfo *hints
@@ -0,0 +1,350 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Vectorized kernels for arrays of numbers.
+//
+// The kernels are written with GCC vector extensions over 32 byte vectors.
+// On x86 each exported kernel is also compiled for AVX2 and the dynamic
+// linker picks the best version for the CPU when the runtime is loaded.
+// Elsewhere the compiler splits the vectors into whatever the target
+// supports.
+
+#include "Numeric.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "ext/Func.h"
+#include "ext/Module.h"
+#include "ext/Type.h"
+
+using namespace crack::ext;
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    (defined(__x86_64__) || defined(__i386__))
+#   define KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#   define KERNEL
+#endif
+
+// The vector helpers are always inlined, so the warning about the ABI for
+// passing vectors without AVX doesn't apply.
+#define INLINE inline __attribute__((always_inline))
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace {
+
+// Integer arithmetic is done on the unsigned type so that overflow wraps
+// like it does in crack.
+template <typename T> struct Arith { typedef T Type; };
+template <> struct Arith<int16_t> { typedef uint16_t Type; };
+template <> struct Arith<int32_t> { typedef uint32_t Type; };
+template <> struct Arith<int64_t> { typedef uint64_t Type; };
+
+// Matrix multiplication block sizes, in elements.  A block of B is
+// K_BLOCK * COL_BLOCK elements, which fits in L2 for 8 byte elements.
+const size_t ROW_BLOCK = 64, K_BLOCK = 128, COL_BLOCK = 256;
+
+template <typename T>
+struct Kernels {
+    typedef typename Arith<T>::Type A;
+    typedef A V __attribute__((vector_size(32)));
+    static const size_t W = sizeof(V) / sizeof(A);
+
+    static INLINE V load(const T *p) {
+        V v;
+        memcpy(&v, p, sizeof(V));
+        return v;
+    }
+
+    static INLINE void store(T *p, const V &v) {
+        memcpy(p, &v, sizeof(V));
+    }
+
+    static INLINE V splat(T s) {
+        V v;
+        for (size_t i = 0; i < W; ++i)
+            v[i] = A(s);
+        return v;
+    }
+
+    static INLINE A total(const V &v) {
+        A result = 0;
+        for (size_t i = 0; i < W; ++i)
+            result += v[i];
+        return result;
+    }
+
+    static inline T dot(const T *a, const T *b, size_t n) {
+        // two accumulators to hide the latency of the adds.
+        V acc0 = splat(0), acc1 = splat(0);
+        size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            acc0 += load(a + i) * load(b + i);
+            acc1 += load(a + i + W) * load(b + i + W);
+        }
+        for (; i + W <= n; i += W)
+            acc0 += load(a + i) * load(b + i);
+        A result = total(acc0 + acc1);
+        for (; i < n; ++i)
+            result += A(a[i]) * A(b[i]);
+        return T(result);
+    }
+
+    static inline T sum(const T *a, size_t n) {
+        V acc0 = splat(0), acc1 = splat(0);
+        size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            acc0 += load(a + i);
+            acc1 += load(a + i + W);
+        }
+        for (; i + W <= n; i += W)
+            acc0 += load(a + i);
+        A result = total(acc0 + acc1);
+        for (; i < n; ++i)
+            result += A(a[i]);
+        return T(result);
+    }
+
+    static inline void fill(T *dst, T val, size_t n) {
+        V v = splat(val);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+            store(dst + i, v);
+        for (; i < n; ++i)
+            dst[i] = val;
+    }
+
+    // c[i] += s * b[i]
+    static inline void axpy(T *c, const T *b, T s, size_t n) {
+        V sv = splat(s);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+            store(c + i, load(c + i) + sv * load(b + i));
+        for (; i < n; ++i)
+            c[i] = T(A(c[i]) + A(s) * A(b[i]));
+    }
+
+    // Computes rows [rowStart, rowEnd) of c = a * b, where a is m x k, b
+    // is k x n and all three are stored in row major order.
+    static inline void matMul(T *c, const T *a, const T *b, size_t k,
+                              size_t n,
+                              size_t rowStart,
+                              size_t rowEnd
+                              ) {
+        for (size_t i = rowStart; i < rowEnd; ++i)
+            fill(c + i * n, 0, n);
+
+        for (size_t i0 = rowStart; i0 < rowEnd; i0 += ROW_BLOCK) {
+            size_t i1 = i0 + ROW_BLOCK < rowEnd ? i0 + ROW_BLOCK : rowEnd;
+            for (size_t p0 = 0; p0 < k; p0 += K_BLOCK) {
+                size_t p1 = p0 + K_BLOCK < k ? p0 + K_BLOCK : k;
+                for (size_t j0 = 0; j0 < n; j0 += COL_BLOCK) {
+                    size_t cols = j0 + COL_BLOCK < n ? COL_BLOCK : n - j0;
+                    for (size_t i = i0; i < i1; ++i)
+                        for (size_t p = p0; p < p1; ++p)
+                            axpy(c + i * n + j0, b + p * n + j0,
+                                 a[i * k + p],
+                                 cols
+                                 );
+                }
+            }
+        }
+    }
+};
+
+#define BINARY_KERNEL(T, name, op) \
+    KERNEL void name(T *dst, const T *a, const T *b, size_t n) {           \
+        typedef Kernels<T> K;                                               \
+        size_t i = 0;                                                       \
+        for (; i + K::W <= n; i += K::W)                                    \
+            K::store(dst + i, K::load(a + i) op K::load(b + i));            \
+        for (; i < n; ++i)                                                  \
+            dst[i] = T(K::A(a[i]) op K::A(b[i]));                           \
+    }
+
+#define SCALAR_KERNEL(T, name, op) \
+    KERNEL void name(T *dst, const T *a, T s, size_t n) {                  \
+        typedef Kernels<T> K;                                               \
+        K::V sv = K::splat(s);                                              \
+        size_t i = 0;                                                       \
+        for (; i + K::W <= n; i += K::W)                                    \
+            K::store(dst + i, K::load(a + i) op sv);                        \
+        for (; i < n; ++i)                                                  \
+            dst[i] = T(K::A(a[i]) op K::A(s));                              \
+    }
+
+// Defines the kernels for element type T, with names ending in 'suffix'.
+#define DEFINE_KERNELS(T, suffix) \
+    KERNEL T vecDot_##suffix(const T *a, const T *b, size_t n) {           \
+        return Kernels<T>::dot(a, b, n);                                    \
+    }                                                                       \
+    KERNEL T vecSum_##suffix(const T *a, size_t n) {                       \
+        return Kernels<T>::sum(a, n);                                       \
+    }                                                                       \
+    KERNEL void vecFill_##suffix(T *dst, T val, size_t n) {                \
+        Kernels<T>::fill(dst, val, n);                                      \
+    }                                                                       \
+    BINARY_KERNEL(T, vecAdd_##suffix, +)                                    \
+    BINARY_KERNEL(T, vecSub_##suffix, -)                                    \
+    BINARY_KERNEL(T, vecMul_##suffix, *)                                    \
+    SCALAR_KERNEL(T, vecAddScalar_##suffix, +)                              \
+    SCALAR_KERNEL(T, vecSubScalar_##suffix, -)                              \
+    SCALAR_KERNEL(T, vecMulScalar_##suffix, *)                              \
+    KERNEL void matMul_##suffix(T *c, const T *a, const T *b, size_t k,    \
+                                size_t n,                                   \
+                                size_t rowStart,                            \
+                                size_t rowEnd                               \
+                                ) {                                         \
+        Kernels<T>::matMul(c, a, b, k, n, rowStart, rowEnd);                \
+    }
+
+// There's no vector instruction for integer division, so it's a plain loop
+// on the signed type.
+#define DEFINE_INT_KERNELS(T, suffix) \
+    DEFINE_KERNELS(T, suffix)                                               \
+    void vecDiv_##suffix(T *dst, const T *a, const T *b, size_t n) {       \
+        for (size_t i = 0; i < n; ++i)                                      \
+            dst[i] = a[i] / b[i];                                           \
+    }                                                                       \
+    void vecDivScalar_##suffix(T *dst, const T *a, T s, size_t n) {        \
+        for (size_t i = 0; i < n; ++i)                                      \
+            dst[i] = a[i] / s;                                              \
+    }
+
+#define DEFINE_FLOAT_KERNELS(T, suffix) \
+    DEFINE_KERNELS(T, suffix)                                               \
+    BINARY_KERNEL(T, vecDiv_##suffix, /)                                    \
+    SCALAR_KERNEL(T, vecDivScalar_##suffix, /)
+
+DEFINE_INT_KERNELS(uint8_t, u8)
+DEFINE_INT_KERNELS(int16_t, i16)
+DEFINE_INT_KERNELS(uint16_t, u16)
+DEFINE_INT_KERNELS(int32_t, i32)
+DEFINE_INT_KERNELS(uint32_t, u32)
+DEFINE_INT_KERNELS(int64_t, i64)
+DEFINE_INT_KERNELS(uint64_t, u64)
+DEFINE_FLOAT_KERNELS(float, f32)
+DEFINE_FLOAT_KERNELS(double, f64)
+
+// Registers the kernels for one crack element type.
+void addKernels(Module *mod, Type *elemType, void *dot, void *sum,
+                void *fill,
+                void *add,
+                void *sub,
+                void *mul,
+                void *div,
+                void *addScalar,
+                void *subScalar,
+                void *mulScalar,
+                void *divScalar,
+                void *matMul
+                ) {
+    Type *voidType = mod->getVoidType();
+    Type *uintzType = mod->getUintzType();
+    Type *arrayType;
+    {
+        std::vector<Type *> params(1);
+        params[0] = elemType;
+        arrayType = mod->getType("array")->getSpecialization(params);
+    }
+    arrayType->finish();
+
+    Func *f = mod->addFunc(elemType, "vecDot", dot);
+    f->addArg(arrayType, "a");
+    f->addArg(arrayType, "b");
+    f->addArg(uintzType, "count");
+
+    f = mod->addFunc(elemType, "vecSum", sum);
+    f->addArg(arrayType, "a");
+    f->addArg(uintzType, "count");
+
+    f = mod->addFunc(voidType, "vecFill", fill);
+    f->addArg(arrayType, "dst");
+    f->addArg(elemType, "val");
+    f->addArg(uintzType, "count");
+
+    const char *binaryNames[] = { "vecAdd", "vecSub", "vecMul", "vecDiv" };
+    void *binaryFuncs[] = { add, sub, mul, div };
+    for (int i = 0; i < 4; ++i) {
+        f = mod->addFunc(voidType, binaryNames[i], binaryFuncs[i]);
+        f->addArg(arrayType, "dst");
+        f->addArg(arrayType, "a");
+        f->addArg(arrayType, "b");
+        f->addArg(uintzType, "count");
+    }
+
+    const char *scalarNames[] = {
+        "vecAddScalar", "vecSubScalar", "vecMulScalar", "vecDivScalar"
+    };
+    void *scalarFuncs[] = { addScalar, subScalar, mulScalar, divScalar };
+    for (int i = 0; i < 4; ++i) {
+        f = mod->addFunc(voidType, scalarNames[i], scalarFuncs[i]);
+        f->addArg(arrayType, "dst");
+        f->addArg(arrayType, "a");
+        f->addArg(elemType, "s");
+        f->addArg(uintzType, "count");
+    }
+
+    f = mod->addFunc(voidType, "matMul", matMul);
+    f->addArg(arrayType, "c");
+    f->addArg(arrayType, "a");
+    f->addArg(arrayType, "b");
+    f->addArg(uintzType, "k");
+    f->addArg(uintzType, "n");
+    f->addArg(uintzType, "rowStart");
+    f->addArg(uintzType, "rowEnd");
+}
+
+#define ADD_KERNELS(type, suffix) \
+    addKernels(mod, type, (void *)vecDot_##suffix, (void *)vecSum_##suffix, \
+               (void *)vecFill_##suffix,                                    \
+               (void *)vecAdd_##suffix,                                     \
+               (void *)vecSub_##suffix,                                     \
+               (void *)vecMul_##suffix,                                     \
+               (void *)vecDiv_##suffix,                                     \
+               (void *)vecAddScalar_##suffix,                               \
+               (void *)vecSubScalar_##suffix,                               \
+               (void *)vecMulScalar_##suffix,                               \
+               (void *)vecDivScalar_##suffix,                               \
+               (void *)matMul_##suffix                                      \
+               )
+
+// Picks the integer kernels matching the size of a C type.
+#define ADD_INT_KERNELS(type, ctype, sign) \
+    if (sizeof(ctype) == 4)                                                 \
+        ADD_KERNELS(type, sign##32);                                        \
+    else                                                                    \
+        ADD_KERNELS(type, sign##64)
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+void addNumericKernels(Module *mod) {
+    ADD_KERNELS(mod->getByteType(), u8);
+    ADD_KERNELS(mod->getInt16Type(), i16);
+    ADD_KERNELS(mod->getUint16Type(), u16);
+    ADD_KERNELS(mod->getInt32Type(), i32);
+    ADD_KERNELS(mod->getUint32Type(), u32);
+    ADD_KERNELS(mod->getInt64Type(), i64);
+    ADD_KERNELS(mod->getUint64Type(), u64);
+    ADD_KERNELS(mod->getFloat32Type(), f32);
+    ADD_KERNELS(mod->getFloat64Type(), f64);
+
+    // the sizes of int, intz and float follow the C types (see
+    // LLVMBuilder).
+    ADD_INT_KERNELS(mod->getIntType(), int, i);
+    ADD_INT_KERNELS(mod->getUintType(), unsigned int, u);
+    ADD_INT_KERNELS(mod->getIntzType(), intptr_t, i);
+    ADD_INT_KERNELS(mod->getUintzType(), uintptr_t, u);
+    if (sizeof(float) == 4)
+        ADD_KERNELS(mod->getFloatType(), f32);
+    else
+        ADD_KERNELS(mod->getFloatType(), f64);
+}
+
+}} // namespace crack::runtime
@@ -0,0 +1,24 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Vectorized kernels for arrays of numbers.
+
+#ifndef _runtime_Numeric_h_
+#define _runtime_Numeric_h_
+
+namespace crack { namespace ext {
+    class Module;
+}}
+
+namespace crack { namespace runtime {
+
+// Adds the vec*() and matMul() functions to 'mod', with overloads for
+// arrays of every numeric primitive type.
+void addNumericKernels(crack::ext::Module *mod);
+
+}} // namespace crack::runtime
+
+#endif
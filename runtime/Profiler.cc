@@ -0,0 +1,246 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Sampling CPU profiler.
+//
+// We use an ITIMER_PROF timer to get SIGPROF at a fixed rate of CPU time.
+// The signal handler records the call stack into a preallocated sample
+// buffer (it can't allocate memory or take locks).  It walks the stack with
+// _Unwind_Backtrace() rather than backtrace(), which isn't async-signal-safe:
+// glibc loads the unwinder with dlopen() on the first call.  We call the
+// unwinder once when the profiler starts so it has initialized itself before
+// the first signal.  The unwinder itself isn't async-signal-safe either, it
+// locks its table of registered frames, so a sample taken while the same
+// thread is throwing an exception through jitted code can deadlock.  The
+// jitted code doesn't keep frame pointers, so there is no safer way to walk
+// through it.  Addresses are
+// symbolized when the profile is written: shared library and exported
+// symbols come from dladdr(), everything else (jitted functions and
+// functions in natively compiled crack programs) from the DebugTools
+// function table.
+//
+// Setting the CRACK_PROFILE environment variable to a file name profiles the
+// entire program and writes the folded stacks to the file at exit.
+// CRACK_PROFILE_FREQUENCY sets the sampling rate (default 100 per second).
+
+#include "Profiler.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <unwind.h>
+#include <sys/time.h>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "debug/DebugTools.h"
+
+using namespace std;
+
+namespace {
+
+    // Maximum depth of a sampled stack.
+    const int MAX_DEPTH = 64;
+
+    // The first two frames of a sample are the signal handler and the
+    // signal trampoline.
+    const int SKIP_FRAMES = 2;
+
+    struct Sample {
+        int depth;
+        void *frames[MAX_DEPTH];
+    };
+
+    Sample *samples;
+    unsigned maxSamples;
+    volatile unsigned sampleCount;
+    volatile unsigned droppedSamples;
+    bool running;
+    struct sigaction oldAction;
+
+    // Stores the address of each frame visited by _Unwind_Backtrace() in a
+    // sample.
+    _Unwind_Reason_Code recordFrame(_Unwind_Context *context, void *arg) {
+        Sample *sample = static_cast<Sample *>(arg);
+        if (sample->depth == MAX_DEPTH)
+            return _URC_END_OF_STACK;
+        sample->frames[sample->depth++] =
+            reinterpret_cast<void *>(_Unwind_GetIP(context));
+        return _URC_NO_REASON;
+    }
+
+    void handleSigprof(int signal) {
+        int savedErrno = errno;
+        unsigned index = __sync_fetch_and_add(&sampleCount, 1);
+        if (index < maxSamples) {
+            Sample &sample = samples[index];
+            sample.depth = 0;
+            _Unwind_Backtrace(recordFrame, &sample);
+        } else {
+            __sync_fetch_and_add(&droppedSamples, 1);
+        }
+        errno = savedErrno;
+    }
+
+    string getFrameName(void *address) {
+        Dl_info info;
+        if (dladdr(address, &info) && info.dli_sname)
+            return info.dli_sname;
+
+        const char *location[3];
+        crack::debug::getLocation(address, location);
+        string name = location[0] ? location[0] : "unknown";
+
+        // semicolons are the frame separator in the folded format.
+        for (size_t i = 0; i < name.size(); ++i)
+            if (name[i] == ';')
+                name[i] = ':';
+        return name;
+    }
+
+    void writeAtExit() {
+        crack::runtime::stopProfiler();
+        int fd = open(getenv("CRACK_PROFILE"), O_CREAT | O_TRUNC | O_WRONLY,
+                      0666
+                      );
+        if (fd != -1) {
+            crack::runtime::writeProfile(fd);
+            close(fd);
+        }
+    }
+
+    bool startFromEnvironment() {
+        if (!getenv("CRACK_PROFILE"))
+            return false;
+
+        int frequency = 100;
+        if (const char *val = getenv("CRACK_PROFILE_FREQUENCY"))
+            frequency = atoi(val);
+        if (!crack::runtime::startProfiler(frequency, 100000))
+            return false;
+        atexit(writeAtExit);
+        return true;
+    }
+
+    bool startedFromEnvironment = startFromEnvironment();
+
+} // anonymous namespace
+
+namespace crack { namespace runtime {
+
+bool startProfiler(int frequency, unsigned bufferSize) {
+    if (running || frequency <= 0 || !bufferSize)
+        return false;
+
+    free(samples);
+    samples = static_cast<Sample *>(malloc(sizeof(Sample) * bufferSize));
+    if (!samples)
+        return false;
+    maxSamples = bufferSize;
+    sampleCount = 0;
+    droppedSamples = 0;
+
+    // The first walk of the stack may allocate memory, so get it out of the
+    // way before we do it in the signal handler.
+    Sample warmup;
+    warmup.depth = 0;
+    _Unwind_Backtrace(recordFrame, &warmup);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleSigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &oldAction))
+        return false;
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = frequency > 1000000 ? 1 : 1000000 / frequency;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, 0)) {
+        sigaction(SIGPROF, &oldAction, 0);
+        return false;
+    }
+
+    running = true;
+    return true;
+}
+
+void stopProfiler() {
+    if (!running)
+        return;
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, 0);
+    sigaction(SIGPROF, &oldAction, 0);
+    running = false;
+}
+
+int writeProfile(int fd) {
+    unsigned count = sampleCount < maxSamples ? sampleCount : maxSamples;
+
+    // Fold the samples.  We symbolize each distinct address only once.
+    typedef map<void *, string> NameMap;
+    typedef map<string, int> StackMap;
+    NameMap names;
+    StackMap stacks;
+    for (unsigned i = 0; i < count; ++i) {
+        const Sample &sample = samples[i];
+        string stack;
+        for (int j = sample.depth - 1; j >= SKIP_FRAMES; --j) {
+            // Except for the innermost frame, addresses are return addresses
+            // and may belong to the next function.
+            void *address = sample.frames[j];
+            if (j != SKIP_FRAMES)
+                address = static_cast<char *>(address) - 1;
+
+            NameMap::iterator iter = names.find(address);
+            if (iter == names.end())
+                iter = names.insert(
+                    make_pair(address, getFrameName(address))
+                ).first;
+
+            if (!stack.empty())
+                stack += ';';
+            stack += iter->second;
+        }
+        if (!stack.empty())
+            ++stacks[stack];
+    }
+
+    ostringstream out;
+    for (StackMap::iterator iter = stacks.begin(); iter != stacks.end();
+         ++iter
+         )
+        out << iter->first << ' ' << iter->second << '\n';
+
+    string data = out.str();
+    const char *cur = data.data();
+    size_t remaining = data.size();
+    while (remaining) {
+        ssize_t rc = write(fd, cur, remaining);
+        if (rc <= 0)
+            break;
+        cur += rc;
+        remaining -= rc;
+    }
+
+    return count;
+}
+
+unsigned getDroppedSamples() {
+    return droppedSamples;
+}
+
+}} // namespace crack::runtime
@@ -0,0 +1,36 @@
+// Copyright 2014 Google Inc.
+//
+//   This Source Code Form is subject to the terms of the Mozilla Public
+//   License, v. 2.0. If a copy of the MPL was not distributed with this
+//   file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Sampling CPU profiler.
+
+#ifndef _runtime_Profiler_h_
+#define _runtime_Profiler_h_
+
+namespace crack { namespace runtime {
+
+// Start sampling the call stack 'frequency' times per second of CPU time.
+// 'bufferSize' is the number of samples to allocate space for, samples
+// beyond this are counted but discarded.  Returns false if the profiler is
+// already running or can't be started.
+bool startProfiler(int frequency, unsigned bufferSize);
+
+// Stop sampling.  The samples are kept until the next startProfiler().
+void stopProfiler();
+
+// Write the samples to the file descriptor as "folded stacks": one line per
+// distinct stack consisting of semicolon separated function names from the
+// outermost to the innermost frame, followed by a space and the number of
+// samples.  This is the input format of flamegraph.pl.  Returns the number
+// of samples written.  This should be called after stopProfiler().
+int writeProfile(int fd);
+
+// Returns the number of samples that were discarded because the sample
+// buffer was full.
+unsigned getDroppedSamples();
+
+}} // namespace crack::runtime
+
+#endif
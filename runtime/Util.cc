@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <utime.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -102,6 +103,63 @@ int setNonBlocking(int fd, int val) {
     return fcntl(fd, F_SETFL, flags);
 }
 
+int64_t fileSize(int fd) {
+    struct stat st;
+    if (fstat(fd, &st))
+        return -1;
+    return st.st_size;
+}
+
+int writePair(int fd, const char *first, unsigned int firstSize,
+              const char *second, unsigned int secondSize
+              ) {
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char *>(first);
+    iov[0].iov_len = firstSize;
+    iov[1].iov_base = const_cast<char *>(second);
+    iov[1].iov_len = secondSize;
+
+    // keep going until everything is written, writev() can stop short on
+    // pipes and sockets.
+    int total = 0, i = 0;
+    while (i < 2) {
+        ssize_t rc = writev(fd, iov + i, 2 - i);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            return total ? total : -1;
+        }
+        total += rc;
+        while (i < 2 && rc >= (ssize_t)iov[i].iov_len) {
+            rc -= iov[i].iov_len;
+            ++i;
+        }
+        if (i < 2) {
+            iov[i].iov_base = (char *)iov[i].iov_base + rc;
+            iov[i].iov_len -= rc;
+        }
+    }
+    return total;
+}
+
+int writeVector(int fd, char **bufs, unsigned int *sizes,
+                unsigned int count
+                ) {
+    struct iovec iov[64];
+    if (count > 64)
+        count = 64;
+    for (unsigned int i = 0; i < count; ++i) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = sizes[i];
+    }
+
+    ssize_t rc;
+    do {
+        rc = writev(fd, iov, count);
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+}
+
 int setUtimes(const char *path,
                          int64_t atv_usecs,
                          int64_t mtv_usecs,
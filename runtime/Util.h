@@ -31,6 +31,23 @@ void printuint64(uint64_t val);
 int is_file(const char *path);
 bool fileExists(const char *path);
 int setNonBlocking(int fd, int val);
+
+// Returns the size of the file open on 'fd', or -1 on error.
+int64_t fileSize(int fd);
+
+// Writes both buffers to 'fd' with writev(), retrying short and interrupted
+// writes until everything has been written.  Returns the number of bytes
+// written, which is less than the total size if there was an error (or a
+// non-blocking descriptor was full) after some of the data was written, or
+// -1 if nothing could be written.
+int writePair(int fd, const char *first, unsigned int firstSize,
+              const char *second, unsigned int secondSize
+              );
+// Writes the first 'count' buffers (at most 64) to 'fd' with a single
+// writev() call.  Unlike writePair(), this doesn't retry short writes so it
+// can be used with non-blocking descriptors.  Returns the number of bytes
+// written or -1 on error.
+int writeVector(int fd, char **bufs, unsigned int *sizes, unsigned int count);
 int setUtimes(const char *path, int64_t atv_usecs, int64_t mtv_usecs, bool now);
 
 char *crk_iconv(unsigned int targetCharSize, const char *to, const char *from, char *string, unsigned int len, unsigned int *convertedLen);
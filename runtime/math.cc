@@ -128,7 +128,7 @@ float crk_strtof(char *s) {
    return (float)strtof(s, (char**)NULL);
 }
 
-float crk_strtod(char *s) {
+double crk_strtod(char *s) {
     errno = 0;
     return (double)strtod(s, (char**)NULL);
 }